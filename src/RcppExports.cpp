@@ -8,8 +8,8 @@
 using namespace Rcpp;
 
 // EstimateBessel
-arma::mat EstimateBessel(const arma::mat& X, const arma::uvec& labels, const arma::vec& lb, const arma::vec& ub, const double rho1, const double rho2, const double alpha1, const double alpha2, const bool estimate_alpha);
-RcppExport SEXP _mediator_EstimateBessel(SEXP XSEXP, SEXP labelsSEXP, SEXP lbSEXP, SEXP ubSEXP, SEXP rho1SEXP, SEXP rho2SEXP, SEXP alpha1SEXP, SEXP alpha2SEXP, SEXP estimate_alphaSEXP) {
+Rcpp::NumericMatrix EstimateBessel(const arma::mat& X, const arma::uvec& labels, const arma::vec& lb, const arma::vec& ub, const double rho1, const double rho2, const double alpha1, const double alpha2, const bool estimate_alpha, const double interpolation_tolerance, const unsigned int num_threads, const std::string method, const double sparse_tolerance, const unsigned int num_probes, const bool single_precision, const unsigned int num_correction_probes, const bool verbose, const bool profile);
+RcppExport SEXP _mediator_EstimateBessel(SEXP XSEXP, SEXP labelsSEXP, SEXP lbSEXP, SEXP ubSEXP, SEXP rho1SEXP, SEXP rho2SEXP, SEXP alpha1SEXP, SEXP alpha2SEXP, SEXP estimate_alphaSEXP, SEXP interpolation_toleranceSEXP, SEXP num_threadsSEXP, SEXP methodSEXP, SEXP sparse_toleranceSEXP, SEXP num_probesSEXP, SEXP single_precisionSEXP, SEXP num_correction_probesSEXP, SEXP verboseSEXP, SEXP profileSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -22,13 +22,45 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const double >::type alpha1(alpha1SEXP);
     Rcpp::traits::input_parameter< const double >::type alpha2(alpha2SEXP);
     Rcpp::traits::input_parameter< const bool >::type estimate_alpha(estimate_alphaSEXP);
-    rcpp_result_gen = Rcpp::wrap(EstimateBessel(X, labels, lb, ub, rho1, rho2, alpha1, alpha2, estimate_alpha));
+    Rcpp::traits::input_parameter< const double >::type interpolation_tolerance(interpolation_toleranceSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_threads(num_threadsSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< const double >::type sparse_tolerance(sparse_toleranceSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_probes(num_probesSEXP);
+    Rcpp::traits::input_parameter< const bool >::type single_precision(single_precisionSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_correction_probes(num_correction_probesSEXP);
+    Rcpp::traits::input_parameter< const bool >::type verbose(verboseSEXP);
+    Rcpp::traits::input_parameter< const bool >::type profile(profileSEXP);
+    rcpp_result_gen = Rcpp::wrap(EstimateBessel(X, labels, lb, ub, rho1, rho2, alpha1, alpha2, estimate_alpha, interpolation_tolerance, num_threads, method, sparse_tolerance, num_probes, single_precision, num_correction_probes, verbose, profile));
+    return rcpp_result_gen;
+END_RCPP
+}
+// EstimateBesselBatch
+arma::mat EstimateBesselBatch(const Rcpp::List& X_list, const Rcpp::List& labels_list, const arma::vec& lb, const arma::vec& ub, const arma::vec& rho1, const arma::vec& rho2, const arma::mat& starting_points, const double interpolation_tolerance, const unsigned int num_threads, const double sparse_tolerance, const unsigned int num_probes, const bool single_precision, const unsigned int num_correction_probes);
+RcppExport SEXP _mediator_EstimateBesselBatch(SEXP X_listSEXP, SEXP labels_listSEXP, SEXP lbSEXP, SEXP ubSEXP, SEXP rho1SEXP, SEXP rho2SEXP, SEXP starting_pointsSEXP, SEXP interpolation_toleranceSEXP, SEXP num_threadsSEXP, SEXP sparse_toleranceSEXP, SEXP num_probesSEXP, SEXP single_precisionSEXP, SEXP num_correction_probesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::List& >::type X_list(X_listSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::List& >::type labels_list(labels_listSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type lb(lbSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type ub(ubSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type rho1(rho1SEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type rho2(rho2SEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type starting_points(starting_pointsSEXP);
+    Rcpp::traits::input_parameter< const double >::type interpolation_tolerance(interpolation_toleranceSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_threads(num_threadsSEXP);
+    Rcpp::traits::input_parameter< const double >::type sparse_tolerance(sparse_toleranceSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_probes(num_probesSEXP);
+    Rcpp::traits::input_parameter< const bool >::type single_precision(single_precisionSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_correction_probes(num_correction_probesSEXP);
+    rcpp_result_gen = Rcpp::wrap(EstimateBesselBatch(X_list, labels_list, lb, ub, rho1, rho2, starting_points, interpolation_tolerance, num_threads, sparse_tolerance, num_probes, single_precision, num_correction_probes));
     return rcpp_result_gen;
 END_RCPP
 }
 // EvaluateBessel
-double EvaluateBessel(const arma::vec& p, const arma::mat& X, const arma::uvec& labels, const arma::vec& lb, const arma::vec& ub, const double rho1, const double rho2);
-RcppExport SEXP _mediator_EvaluateBessel(SEXP pSEXP, SEXP XSEXP, SEXP labelsSEXP, SEXP lbSEXP, SEXP ubSEXP, SEXP rho1SEXP, SEXP rho2SEXP) {
+double EvaluateBessel(const arma::vec& p, const arma::mat& X, const arma::uvec& labels, const arma::vec& lb, const arma::vec& ub, const double rho1, const double rho2, const double interpolation_tolerance, const unsigned int num_threads, const double sparse_tolerance, const unsigned int num_probes, const bool single_precision, const unsigned int num_correction_probes);
+RcppExport SEXP _mediator_EvaluateBessel(SEXP pSEXP, SEXP XSEXP, SEXP labelsSEXP, SEXP lbSEXP, SEXP ubSEXP, SEXP rho1SEXP, SEXP rho2SEXP, SEXP interpolation_toleranceSEXP, SEXP num_threadsSEXP, SEXP sparse_toleranceSEXP, SEXP num_probesSEXP, SEXP single_precisionSEXP, SEXP num_correction_probesSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -39,7 +71,36 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const arma::vec& >::type ub(ubSEXP);
     Rcpp::traits::input_parameter< const double >::type rho1(rho1SEXP);
     Rcpp::traits::input_parameter< const double >::type rho2(rho2SEXP);
-    rcpp_result_gen = Rcpp::wrap(EvaluateBessel(p, X, labels, lb, ub, rho1, rho2));
+    Rcpp::traits::input_parameter< const double >::type interpolation_tolerance(interpolation_toleranceSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_threads(num_threadsSEXP);
+    Rcpp::traits::input_parameter< const double >::type sparse_tolerance(sparse_toleranceSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_probes(num_probesSEXP);
+    Rcpp::traits::input_parameter< const bool >::type single_precision(single_precisionSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_correction_probes(num_correction_probesSEXP);
+    rcpp_result_gen = Rcpp::wrap(EvaluateBessel(p, X, labels, lb, ub, rho1, rho2, interpolation_tolerance, num_threads, sparse_tolerance, num_probes, single_precision, num_correction_probes));
+    return rcpp_result_gen;
+END_RCPP
+}
+// CreateBesselLogLikelihood
+SEXP CreateBesselLogLikelihood(const arma::mat& X, const arma::uvec& labels, const arma::vec& lb, const arma::vec& ub, const double rho1, const double rho2, const double interpolation_tolerance, const unsigned int num_threads, const double sparse_tolerance, const unsigned int num_probes, const bool single_precision, const unsigned int num_correction_probes, const bool profile);
+RcppExport SEXP _mediator_CreateBesselLogLikelihood(SEXP XSEXP, SEXP labelsSEXP, SEXP lbSEXP, SEXP ubSEXP, SEXP rho1SEXP, SEXP rho2SEXP, SEXP interpolation_toleranceSEXP, SEXP num_threadsSEXP, SEXP sparse_toleranceSEXP, SEXP num_probesSEXP, SEXP single_precisionSEXP, SEXP num_correction_probesSEXP, SEXP profileSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type labels(labelsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type lb(lbSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type ub(ubSEXP);
+    Rcpp::traits::input_parameter< const double >::type rho1(rho1SEXP);
+    Rcpp::traits::input_parameter< const double >::type rho2(rho2SEXP);
+    Rcpp::traits::input_parameter< const double >::type interpolation_tolerance(interpolation_toleranceSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_threads(num_threadsSEXP);
+    Rcpp::traits::input_parameter< const double >::type sparse_tolerance(sparse_toleranceSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_probes(num_probesSEXP);
+    Rcpp::traits::input_parameter< const bool >::type single_precision(single_precisionSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_correction_probes(num_correction_probesSEXP);
+    Rcpp::traits::input_parameter< const bool >::type profile(profileSEXP);
+    rcpp_result_gen = Rcpp::wrap(CreateBesselLogLikelihood(X, labels, lb, ub, rho1, rho2, interpolation_tolerance, num_threads, sparse_tolerance, num_probes, single_precision, num_correction_probes, profile));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -62,11 +123,384 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// CompareBesselJRatio
+Rcpp::List CompareBesselJRatio(const arma::vec& x, const unsigned int dimension, const double tolerance);
+RcppExport SEXP _mediator_CompareBesselJRatio(SEXP xSEXP, SEXP dimensionSEXP, SEXP toleranceSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type x(xSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type dimension(dimensionSEXP);
+    Rcpp::traits::input_parameter< const double >::type tolerance(toleranceSEXP);
+    rcpp_result_gen = Rcpp::wrap(CompareBesselJRatio(x, dimension, tolerance));
+    return rcpp_result_gen;
+END_RCPP
+}
+// EvaluateGauss
+double EvaluateGauss(const arma::vec& p, const arma::mat& X, const arma::uvec& labels, const arma::vec& lb, const arma::vec& ub, const double rho1, const double rho2, const unsigned int num_threads, const double sparse_tolerance, const unsigned int num_probes, const bool single_precision, const unsigned int num_correction_probes);
+RcppExport SEXP _mediator_EvaluateGauss(SEXP pSEXP, SEXP XSEXP, SEXP labelsSEXP, SEXP lbSEXP, SEXP ubSEXP, SEXP rho1SEXP, SEXP rho2SEXP, SEXP num_threadsSEXP, SEXP sparse_toleranceSEXP, SEXP num_probesSEXP, SEXP single_precisionSEXP, SEXP num_correction_probesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type p(pSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type labels(labelsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type lb(lbSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type ub(ubSEXP);
+    Rcpp::traits::input_parameter< const double >::type rho1(rho1SEXP);
+    Rcpp::traits::input_parameter< const double >::type rho2(rho2SEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_threads(num_threadsSEXP);
+    Rcpp::traits::input_parameter< const double >::type sparse_tolerance(sparse_toleranceSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_probes(num_probesSEXP);
+    Rcpp::traits::input_parameter< const bool >::type single_precision(single_precisionSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_correction_probes(num_correction_probesSEXP);
+    rcpp_result_gen = Rcpp::wrap(EvaluateGauss(p, X, labels, lb, ub, rho1, rho2, num_threads, sparse_tolerance, num_probes, single_precision, num_correction_probes));
+    return rcpp_result_gen;
+END_RCPP
+}
+// CreateGaussLogLikelihood
+SEXP CreateGaussLogLikelihood(const arma::mat& X, const arma::uvec& labels, const arma::vec& lb, const arma::vec& ub, const double rho1, const double rho2, const unsigned int num_threads, const double sparse_tolerance, const unsigned int num_probes, const bool single_precision, const unsigned int num_correction_probes, const bool profile);
+RcppExport SEXP _mediator_CreateGaussLogLikelihood(SEXP XSEXP, SEXP labelsSEXP, SEXP lbSEXP, SEXP ubSEXP, SEXP rho1SEXP, SEXP rho2SEXP, SEXP num_threadsSEXP, SEXP sparse_toleranceSEXP, SEXP num_probesSEXP, SEXP single_precisionSEXP, SEXP num_correction_probesSEXP, SEXP profileSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type labels(labelsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type lb(lbSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type ub(ubSEXP);
+    Rcpp::traits::input_parameter< const double >::type rho1(rho1SEXP);
+    Rcpp::traits::input_parameter< const double >::type rho2(rho2SEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_threads(num_threadsSEXP);
+    Rcpp::traits::input_parameter< const double >::type sparse_tolerance(sparse_toleranceSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_probes(num_probesSEXP);
+    Rcpp::traits::input_parameter< const bool >::type single_precision(single_precisionSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_correction_probes(num_correction_probesSEXP);
+    Rcpp::traits::input_parameter< const bool >::type profile(profileSEXP);
+    rcpp_result_gen = Rcpp::wrap(CreateGaussLogLikelihood(X, labels, lb, ub, rho1, rho2, num_threads, sparse_tolerance, num_probes, single_precision, num_correction_probes, profile));
+    return rcpp_result_gen;
+END_RCPP
+}
+// InitializeGauss
+arma::mat InitializeGauss(const arma::mat& X, const arma::uvec& labels, const arma::vec& lb, const arma::vec& ub, const double rho1, const double rho2, const double alpha1, const double alpha2, const bool estimate_alpha);
+RcppExport SEXP _mediator_InitializeGauss(SEXP XSEXP, SEXP labelsSEXP, SEXP lbSEXP, SEXP ubSEXP, SEXP rho1SEXP, SEXP rho2SEXP, SEXP alpha1SEXP, SEXP alpha2SEXP, SEXP estimate_alphaSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type labels(labelsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type lb(lbSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type ub(ubSEXP);
+    Rcpp::traits::input_parameter< const double >::type rho1(rho1SEXP);
+    Rcpp::traits::input_parameter< const double >::type rho2(rho2SEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha1(alpha1SEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha2(alpha2SEXP);
+    Rcpp::traits::input_parameter< const bool >::type estimate_alpha(estimate_alphaSEXP);
+    rcpp_result_gen = Rcpp::wrap(InitializeGauss(X, labels, lb, ub, rho1, rho2, alpha1, alpha2, estimate_alpha));
+    return rcpp_result_gen;
+END_RCPP
+}
+// EvaluateLogLikelihood
+double EvaluateLogLikelihood(const arma::vec& p, SEXP likelihood);
+RcppExport SEXP _mediator_EvaluateLogLikelihood(SEXP pSEXP, SEXP likelihoodSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type p(pSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type likelihood(likelihoodSEXP);
+    rcpp_result_gen = Rcpp::wrap(EvaluateLogLikelihood(p, likelihood));
+    return rcpp_result_gen;
+END_RCPP
+}
+// EvaluateLogLikelihoodGradient
+arma::vec EvaluateLogLikelihoodGradient(const arma::vec& p, SEXP likelihood);
+RcppExport SEXP _mediator_EvaluateLogLikelihoodGradient(SEXP pSEXP, SEXP likelihoodSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type p(pSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type likelihood(likelihoodSEXP);
+    rcpp_result_gen = Rcpp::wrap(EvaluateLogLikelihoodGradient(p, likelihood));
+    return rcpp_result_gen;
+END_RCPP
+}
+// CheckLogLikelihoodGradient
+arma::mat CheckLogLikelihoodGradient(const arma::vec& p, SEXP likelihood, const double step);
+RcppExport SEXP _mediator_CheckLogLikelihoodGradient(SEXP pSEXP, SEXP likelihoodSEXP, SEXP stepSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type p(pSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type likelihood(likelihoodSEXP);
+    Rcpp::traits::input_parameter< const double >::type step(stepSEXP);
+    rcpp_result_gen = Rcpp::wrap(CheckLogLikelihoodGradient(p, likelihood, step));
+    return rcpp_result_gen;
+END_RCPP
+}
+// GetLogDeterminantError
+double GetLogDeterminantError(SEXP likelihood);
+RcppExport SEXP _mediator_GetLogDeterminantError(SEXP likelihoodSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type likelihood(likelihoodSEXP);
+    rcpp_result_gen = Rcpp::wrap(GetLogDeterminantError(likelihood));
+    return rcpp_result_gen;
+END_RCPP
+}
+// GetLogLikelihoodProfile
+Rcpp::List GetLogLikelihoodProfile(SEXP likelihood);
+RcppExport SEXP _mediator_GetLogLikelihoodProfile(SEXP likelihoodSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type likelihood(likelihoodSEXP);
+    rcpp_result_gen = Rcpp::wrap(GetLogLikelihoodProfile(likelihood));
+    return rcpp_result_gen;
+END_RCPP
+}
+// TimeLogLikelihood
+Rcpp::List TimeLogLikelihood(const arma::vec& p, SEXP likelihood, const unsigned int num_repeats);
+RcppExport SEXP _mediator_TimeLogLikelihood(SEXP pSEXP, SEXP likelihoodSEXP, SEXP num_repeatsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type p(pSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type likelihood(likelihoodSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_repeats(num_repeatsSEXP);
+    rcpp_result_gen = Rcpp::wrap(TimeLogLikelihood(p, likelihood, num_repeats));
+    return rcpp_result_gen;
+END_RCPP
+}
+// EvaluateLMatrixEntries
+Rcpp::List EvaluateLMatrixEntries(const arma::vec& p, SEXP likelihood, const arma::vec& r);
+RcppExport SEXP _mediator_EvaluateLMatrixEntries(SEXP pSEXP, SEXP likelihoodSEXP, SEXP rSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type p(pSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type likelihood(likelihoodSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type r(rSEXP);
+    rcpp_result_gen = Rcpp::wrap(EvaluateLMatrixEntries(p, likelihood, r));
+    return rcpp_result_gen;
+END_RCPP
+}
+// EvaluateMatern
+double EvaluateMatern(const arma::vec& p, const arma::mat& X, const arma::uvec& labels, const arma::vec& lb, const arma::vec& ub, const double rho1, const double rho2, const double nu, const double interpolation_tolerance, const unsigned int num_threads, const double sparse_tolerance, const unsigned int num_probes, const bool single_precision, const unsigned int num_correction_probes);
+RcppExport SEXP _mediator_EvaluateMatern(SEXP pSEXP, SEXP XSEXP, SEXP labelsSEXP, SEXP lbSEXP, SEXP ubSEXP, SEXP rho1SEXP, SEXP rho2SEXP, SEXP nuSEXP, SEXP interpolation_toleranceSEXP, SEXP num_threadsSEXP, SEXP sparse_toleranceSEXP, SEXP num_probesSEXP, SEXP single_precisionSEXP, SEXP num_correction_probesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type p(pSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type labels(labelsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type lb(lbSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type ub(ubSEXP);
+    Rcpp::traits::input_parameter< const double >::type rho1(rho1SEXP);
+    Rcpp::traits::input_parameter< const double >::type rho2(rho2SEXP);
+    Rcpp::traits::input_parameter< const double >::type nu(nuSEXP);
+    Rcpp::traits::input_parameter< const double >::type interpolation_tolerance(interpolation_toleranceSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_threads(num_threadsSEXP);
+    Rcpp::traits::input_parameter< const double >::type sparse_tolerance(sparse_toleranceSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_probes(num_probesSEXP);
+    Rcpp::traits::input_parameter< const bool >::type single_precision(single_precisionSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_correction_probes(num_correction_probesSEXP);
+    rcpp_result_gen = Rcpp::wrap(EvaluateMatern(p, X, labels, lb, ub, rho1, rho2, nu, interpolation_tolerance, num_threads, sparse_tolerance, num_probes, single_precision, num_correction_probes));
+    return rcpp_result_gen;
+END_RCPP
+}
+// CreateMaternLogLikelihood
+SEXP CreateMaternLogLikelihood(const arma::mat& X, const arma::uvec& labels, const arma::vec& lb, const arma::vec& ub, const double rho1, const double rho2, const double nu, const double interpolation_tolerance, const unsigned int num_threads, const double sparse_tolerance, const unsigned int num_probes, const bool single_precision, const unsigned int num_correction_probes, const bool profile);
+RcppExport SEXP _mediator_CreateMaternLogLikelihood(SEXP XSEXP, SEXP labelsSEXP, SEXP lbSEXP, SEXP ubSEXP, SEXP rho1SEXP, SEXP rho2SEXP, SEXP nuSEXP, SEXP interpolation_toleranceSEXP, SEXP num_threadsSEXP, SEXP sparse_toleranceSEXP, SEXP num_probesSEXP, SEXP single_precisionSEXP, SEXP num_correction_probesSEXP, SEXP profileSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type labels(labelsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type lb(lbSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type ub(ubSEXP);
+    Rcpp::traits::input_parameter< const double >::type rho1(rho1SEXP);
+    Rcpp::traits::input_parameter< const double >::type rho2(rho2SEXP);
+    Rcpp::traits::input_parameter< const double >::type nu(nuSEXP);
+    Rcpp::traits::input_parameter< const double >::type interpolation_tolerance(interpolation_toleranceSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_threads(num_threadsSEXP);
+    Rcpp::traits::input_parameter< const double >::type sparse_tolerance(sparse_toleranceSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_probes(num_probesSEXP);
+    Rcpp::traits::input_parameter< const bool >::type single_precision(single_precisionSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_correction_probes(num_correction_probesSEXP);
+    Rcpp::traits::input_parameter< const bool >::type profile(profileSEXP);
+    rcpp_result_gen = Rcpp::wrap(CreateMaternLogLikelihood(X, labels, lb, ub, rho1, rho2, nu, interpolation_tolerance, num_threads, sparse_tolerance, num_probes, single_precision, num_correction_probes, profile));
+    return rcpp_result_gen;
+END_RCPP
+}
+// InitializeMatern
+arma::mat InitializeMatern(const arma::mat& X, const arma::uvec& labels, const arma::vec& lb, const arma::vec& ub, const double rho1, const double rho2, const double alpha1, const double alpha2, const bool estimate_alpha);
+RcppExport SEXP _mediator_InitializeMatern(SEXP XSEXP, SEXP labelsSEXP, SEXP lbSEXP, SEXP ubSEXP, SEXP rho1SEXP, SEXP rho2SEXP, SEXP alpha1SEXP, SEXP alpha2SEXP, SEXP estimate_alphaSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type labels(labelsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type lb(lbSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type ub(ubSEXP);
+    Rcpp::traits::input_parameter< const double >::type rho1(rho1SEXP);
+    Rcpp::traits::input_parameter< const double >::type rho2(rho2SEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha1(alpha1SEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha2(alpha2SEXP);
+    Rcpp::traits::input_parameter< const bool >::type estimate_alpha(estimate_alphaSEXP);
+    rcpp_result_gen = Rcpp::wrap(InitializeMatern(X, labels, lb, ub, rho1, rho2, alpha1, alpha2, estimate_alpha));
+    return rcpp_result_gen;
+END_RCPP
+}
+// CompareMaternCorrelation
+Rcpp::List CompareMaternCorrelation(const arma::vec& x, const double nu, const double tolerance);
+RcppExport SEXP _mediator_CompareMaternCorrelation(SEXP xSEXP, SEXP nuSEXP, SEXP toleranceSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type x(xSEXP);
+    Rcpp::traits::input_parameter< const double >::type nu(nuSEXP);
+    Rcpp::traits::input_parameter< const double >::type tolerance(toleranceSEXP);
+    rcpp_result_gen = Rcpp::wrap(CompareMaternCorrelation(x, nu, tolerance));
+    return rcpp_result_gen;
+END_RCPP
+}
+// EstimatePairCorrelation
+Rcpp::List EstimatePairCorrelation(const arma::mat& X, const arma::uvec& labels, const arma::vec& lb, const arma::vec& ub, const double rmin, const double rmax, const unsigned int nr, const double bw, const std::string divisor);
+RcppExport SEXP _mediator_EstimatePairCorrelation(SEXP XSEXP, SEXP labelsSEXP, SEXP lbSEXP, SEXP ubSEXP, SEXP rminSEXP, SEXP rmaxSEXP, SEXP nrSEXP, SEXP bwSEXP, SEXP divisorSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const arma::uvec& >::type labels(labelsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type lb(lbSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type ub(ubSEXP);
+    Rcpp::traits::input_parameter< const double >::type rmin(rminSEXP);
+    Rcpp::traits::input_parameter< const double >::type rmax(rmaxSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type nr(nrSEXP);
+    Rcpp::traits::input_parameter< const double >::type bw(bwSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type divisor(divisorSEXP);
+    rcpp_result_gen = Rcpp::wrap(EstimatePairCorrelation(X, labels, lb, ub, rmin, rmax, nr, bw, divisor));
+    return rcpp_result_gen;
+END_RCPP
+}
+// GetBesselPCF
+arma::vec GetBesselPCF(const arma::vec& r, const double alpha, const double tau, const unsigned int d);
+RcppExport SEXP _mediator_GetBesselPCF(SEXP rSEXP, SEXP alphaSEXP, SEXP tauSEXP, SEXP dSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type r(rSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< const double >::type tau(tauSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type d(dSEXP);
+    rcpp_result_gen = Rcpp::wrap(GetBesselPCF(r, alpha, tau, d));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ComputeBesselPCFContrast
+double ComputeBesselPCFContrast(const arma::vec& y, const arma::vec& r, const double alpha, const double tau, const unsigned int d, const double p, const double q);
+RcppExport SEXP _mediator_ComputeBesselPCFContrast(SEXP ySEXP, SEXP rSEXP, SEXP alphaSEXP, SEXP tauSEXP, SEXP dSEXP, SEXP pSEXP, SEXP qSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::vec& >::type y(ySEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type r(rSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< const double >::type tau(tauSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type d(dSEXP);
+    Rcpp::traits::input_parameter< const double >::type p(pSEXP);
+    Rcpp::traits::input_parameter< const double >::type q(qSEXP);
+    rcpp_result_gen = Rcpp::wrap(ComputeBesselPCFContrast(y, r, alpha, tau, d, p, q));
+    return rcpp_result_gen;
+END_RCPP
+}
+// CreateSpectralPlan
+SEXP CreateSpectralPlan(const std::string model, const double rho1, const double rho2, const double alpha1, const double alpha2, const double alpha12, const double tau, const arma::vec& lb, const arma::vec& ub, const double nu, const double precision, const unsigned int reject_max);
+RcppExport SEXP _mediator_CreateSpectralPlan(SEXP modelSEXP, SEXP rho1SEXP, SEXP rho2SEXP, SEXP alpha1SEXP, SEXP alpha2SEXP, SEXP alpha12SEXP, SEXP tauSEXP, SEXP lbSEXP, SEXP ubSEXP, SEXP nuSEXP, SEXP precisionSEXP, SEXP reject_maxSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< const double >::type rho1(rho1SEXP);
+    Rcpp::traits::input_parameter< const double >::type rho2(rho2SEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha1(alpha1SEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha2(alpha2SEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha12(alpha12SEXP);
+    Rcpp::traits::input_parameter< const double >::type tau(tauSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type lb(lbSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type ub(ubSEXP);
+    Rcpp::traits::input_parameter< const double >::type nu(nuSEXP);
+    Rcpp::traits::input_parameter< const double >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type reject_max(reject_maxSEXP);
+    rcpp_result_gen = Rcpp::wrap(CreateSpectralPlan(model, rho1, rho2, alpha1, alpha2, alpha12, tau, lb, ub, nu, precision, reject_max));
+    return rcpp_result_gen;
+END_RCPP
+}
+// SampleSpectralPlan
+Rcpp::List SampleSpectralPlan(SEXP plan, const unsigned int n, const double seed, const unsigned int num_threads);
+RcppExport SEXP _mediator_SampleSpectralPlan(SEXP planSEXP, SEXP nSEXP, SEXP seedSEXP, SEXP num_threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type plan(planSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< const double >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type num_threads(num_threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(SampleSpectralPlan(plan, n, seed, num_threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// SimulateBivariateDPP
+Rcpp::List SimulateBivariateDPP(const std::string model, const double rho1, const double rho2, const double alpha1, const double alpha2, const double alpha12, const double tau, const arma::vec& lb, const arma::vec& ub, const double nu, const double precision, const unsigned int reject_max, const double seed);
+RcppExport SEXP _mediator_SimulateBivariateDPP(SEXP modelSEXP, SEXP rho1SEXP, SEXP rho2SEXP, SEXP alpha1SEXP, SEXP alpha2SEXP, SEXP alpha12SEXP, SEXP tauSEXP, SEXP lbSEXP, SEXP ubSEXP, SEXP nuSEXP, SEXP precisionSEXP, SEXP reject_maxSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< const double >::type rho1(rho1SEXP);
+    Rcpp::traits::input_parameter< const double >::type rho2(rho2SEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha1(alpha1SEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha2(alpha2SEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha12(alpha12SEXP);
+    Rcpp::traits::input_parameter< const double >::type tau(tauSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type lb(lbSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type ub(ubSEXP);
+    Rcpp::traits::input_parameter< const double >::type nu(nuSEXP);
+    Rcpp::traits::input_parameter< const double >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< const unsigned int >::type reject_max(reject_maxSEXP);
+    Rcpp::traits::input_parameter< const double >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(SimulateBivariateDPP(model, rho1, rho2, alpha1, alpha2, alpha12, tau, lb, ub, nu, precision, reject_max, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
 
 static const R_CallMethodDef CallEntries[] = {
-    {"_mediator_EstimateBessel", (DL_FUNC) &_mediator_EstimateBessel, 9},
-    {"_mediator_EvaluateBessel", (DL_FUNC) &_mediator_EvaluateBessel, 7},
+    {"_mediator_EstimateBessel", (DL_FUNC) &_mediator_EstimateBessel, 18},
+    {"_mediator_EstimateBesselBatch", (DL_FUNC) &_mediator_EstimateBesselBatch, 13},
+    {"_mediator_EvaluateBessel", (DL_FUNC) &_mediator_EvaluateBessel, 13},
+    {"_mediator_CreateBesselLogLikelihood", (DL_FUNC) &_mediator_CreateBesselLogLikelihood, 13},
     {"_mediator_InitializeBessel", (DL_FUNC) &_mediator_InitializeBessel, 9},
+    {"_mediator_CompareBesselJRatio", (DL_FUNC) &_mediator_CompareBesselJRatio, 3},
+    {"_mediator_EvaluateGauss", (DL_FUNC) &_mediator_EvaluateGauss, 12},
+    {"_mediator_CreateGaussLogLikelihood", (DL_FUNC) &_mediator_CreateGaussLogLikelihood, 12},
+    {"_mediator_InitializeGauss", (DL_FUNC) &_mediator_InitializeGauss, 9},
+    {"_mediator_EvaluateLogLikelihood", (DL_FUNC) &_mediator_EvaluateLogLikelihood, 2},
+    {"_mediator_EvaluateLogLikelihoodGradient", (DL_FUNC) &_mediator_EvaluateLogLikelihoodGradient, 2},
+    {"_mediator_CheckLogLikelihoodGradient", (DL_FUNC) &_mediator_CheckLogLikelihoodGradient, 3},
+    {"_mediator_GetLogDeterminantError", (DL_FUNC) &_mediator_GetLogDeterminantError, 1},
+    {"_mediator_GetLogLikelihoodProfile", (DL_FUNC) &_mediator_GetLogLikelihoodProfile, 1},
+    {"_mediator_TimeLogLikelihood", (DL_FUNC) &_mediator_TimeLogLikelihood, 3},
+    {"_mediator_EvaluateLMatrixEntries", (DL_FUNC) &_mediator_EvaluateLMatrixEntries, 3},
+    {"_mediator_EvaluateMatern", (DL_FUNC) &_mediator_EvaluateMatern, 14},
+    {"_mediator_CreateMaternLogLikelihood", (DL_FUNC) &_mediator_CreateMaternLogLikelihood, 14},
+    {"_mediator_InitializeMatern", (DL_FUNC) &_mediator_InitializeMatern, 9},
+    {"_mediator_CompareMaternCorrelation", (DL_FUNC) &_mediator_CompareMaternCorrelation, 3},
+    {"_mediator_EstimatePairCorrelation", (DL_FUNC) &_mediator_EstimatePairCorrelation, 9},
+    {"_mediator_GetBesselPCF", (DL_FUNC) &_mediator_GetBesselPCF, 4},
+    {"_mediator_ComputeBesselPCFContrast", (DL_FUNC) &_mediator_ComputeBesselPCFContrast, 7},
+    {"_mediator_CreateSpectralPlan", (DL_FUNC) &_mediator_CreateSpectralPlan, 12},
+    {"_mediator_SampleSpectralPlan", (DL_FUNC) &_mediator_SampleSpectralPlan, 4},
+    {"_mediator_SimulateBivariateDPP", (DL_FUNC) &_mediator_SimulateBivariateDPP, 13},
     {NULL, NULL, 0}
 };
 
@@ -1,230 +1,1654 @@
 #include "baseLogLikelihood.h"
-#include <boost/math/quadrature/gauss_kronrod.hpp>
-#include <boost/math/special_functions/bessel.hpp>
+#include "cellList.h"
+#include "philoxGenerator.h"
 #include <boost/math/special_functions/gamma.hpp>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
 
 const double BaseLogLikelihood::m_Epsilon = 1.0e-4;
 
-void BaseLogLikelihood::SetNeighborhood(const unsigned int n)
+arma::uword BaseLogLikelihood::GetPackedRowOffset(const arma::uword i, const arma::uword n)
 {
-  std::vector<int> workVec(n, 0);
-  m_Neighborhood.resize(1);
-  m_Neighborhood[0] = workVec;
-  NeighborhoodType workList;
+  // Row i of a packed strict upper triangle of size n starts after
+  // (n - 1) + (n - 2) + ... + (n - i) entries
+  return i * (2 * n - i - 1) / 2;
+}
+
+void BaseLogLikelihood::ComputeSquaredDistances(
+    const arma::mat &points,
+    const arma::vec &lb,
+    const arma::vec &ub,
+    const unsigned int index,
+    const unsigned int firstIndex,
+    const unsigned int lastIndex,
+    double *sqDistances)
+{
+  // Points are stored column-major so that each coordinate is contiguous. On
+  // a periodic box, the distance is the norm of the per-coordinate minimum
+  // image min(|dx|, |dx - L|), which matches the nearest of the 3^d
+  // translated copies.
+  unsigned int numValues = lastIndex - firstIndex;
+
+  for (unsigned int j = 0;j < numValues;++j)
+    sqDistances[j] = 0.0;
+
+  for (unsigned int k = 0;k < m_DomainDimension;++k)
+  {
+    const double *workCoordinates = points.colptr(k) + firstIndex;
+    double workCoordinate = points(index, k);
+    double domainLength = ub[k] - lb[k];
+
+    if (m_UsePeriodicDomain)
+    {
+      for (unsigned int j = 0;j < numValues;++j)
+      {
+        double workDelta = std::abs(workCoordinates[j] - workCoordinate);
+        workDelta = std::min(workDelta, std::abs(workDelta - domainLength));
+        sqDistances[j] += workDelta * workDelta;
+      }
+    }
+    else
+    {
+      for (unsigned int j = 0;j < numValues;++j)
+      {
+        double workDelta = workCoordinates[j] - workCoordinate;
+        sqDistances[j] += workDelta * workDelta;
+      }
+    }
+  }
+}
+
+void BaseLogLikelihood::SetInputs(
+    const arma::mat &points,
+    const arma::uvec &labels,
+    const arma::vec &lb,
+    const arma::vec &ub)
+{
+  m_DomainDimension = points.n_cols;
+  m_SampleSize = points.n_rows;
+  m_DomainVolume = 1.0;
+  for (unsigned int i = 0;i < m_DomainDimension;++i)
+    m_DomainVolume *= (ub[i] - lb[i]);
+
+  // Points are reordered so that the first label comes first. The
+  // log-determinant is invariant under this permutation of the L-matrix,
+  // which then splits into blocks of same-label and cross pairs.
+  std::vector<unsigned int> sortedIndices;
+  sortedIndices.reserve(m_SampleSize);
+  for (unsigned int i = 0;i < m_SampleSize;++i)
+  {
+    if (labels[i] == 1)
+      sortedIndices.push_back(i);
+  }
+  m_FirstSampleSize = sortedIndices.size();
+  for (unsigned int i = 0;i < m_SampleSize;++i)
+  {
+    if (labels[i] != 1)
+      sortedIndices.push_back(i);
+  }
+  m_SecondSampleSize = m_SampleSize - m_FirstSampleSize;
+
+  arma::mat sortedPoints(m_SampleSize, m_DomainDimension);
+  m_PointLabels.set_size(m_SampleSize);
+  for (unsigned int i = 0;i < m_SampleSize;++i)
+  {
+    m_PointLabels[i] = labels[sortedIndices[i]];
+    for (unsigned int k = 0;k < m_DomainDimension;++k)
+      sortedPoints(i, k) = points(sortedIndices[i], k);
+  }
+
+  // The kernels are set up first since the cutoff radius of the sparse
+  // L-matrix depends on them.
+  if (m_BesselJRatioTolerance > 0.0)
+    m_BesselJRatioTable.Build((double)m_DomainDimension / 2.0, m_BesselJRatioTolerance);
+  else
+    m_BesselJRatioTable.Clear();
+
+  this->InitializeKernel();
+  this->ClearCache();
+
+  unsigned int n1 = m_FirstSampleSize;
+  unsigned int n2 = m_SecondSampleSize;
+  m_UseSparseLMatrix = (m_SparseTolerance > 0.0);
+  m_Profiler.Start(EvaluationProfiler::InputsPhase);
+
+  if (m_UseSparseLMatrix)
+  {
+    m_FirstSquaredDistances.reset();
+    m_CrossSquaredDistances.reset();
+    m_SecondSquaredDistances.reset();
+    this->ComputeNeighbourPairs(sortedPoints, lb, ub);
+    m_MaximalDistance = (m_NeighbourSquaredDistances.n_elem > 0) ? std::sqrt(arma::max(m_NeighbourSquaredDistances)) : 0.0;
+    m_Profiler.Stop(EvaluationProfiler::InputsPhase);
+    return;
+  }
+
+  m_NeighbourRadius = 0.0;
+  m_MaximalNumberOfNeighbours = 0;
+  m_NeighbourStarts.clear();
+  m_NeighbourIndices.clear();
+  m_NeighbourSquaredDistances.reset();
+  m_NeighbourPositions.clear();
+  m_DiagonalPositions.clear();
+
+  // Squared distances are stored once per pair, grouped by label
+  // combination: packed strict upper triangles for the same-label pairs and
+  // the full n1 x n2 block, row by row, for the cross pairs. Each row is
+  // filled by a single thread so that the result does not depend on the
+  // number of threads.
+  m_FirstSquaredDistances.set_size((arma::uword)n1 * (n1 - 1) / 2);
+  m_CrossSquaredDistances.set_size((arma::uword)n1 * n2);
+  m_SecondSquaredDistances.set_size((arma::uword)n2 * (n2 - 1) / 2);
+
+  ParallelErrorHandler errorHandler;
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(m_NumberOfThreads)
+#endif
+  for (unsigned int i = 0;i < n1;++i)
+  {
+    try
+    {
+      this->ComputeSquaredDistances(sortedPoints, lb, ub, i, i + 1, n1, m_FirstSquaredDistances.memptr() + this->GetPackedRowOffset(i, n1));
+      this->ComputeSquaredDistances(sortedPoints, lb, ub, i, n1, n1 + n2, m_CrossSquaredDistances.memptr() + (arma::uword)i * n2);
+    }
+    catch (std::exception &e)
+    {
+      errorHandler.Store(i, e);
+    }
+  }
+
+  errorHandler.Rethrow();
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(m_NumberOfThreads)
+#endif
+  for (unsigned int i = 0;i < n2;++i)
+  {
+    try
+    {
+      this->ComputeSquaredDistances(sortedPoints, lb, ub, n1 + i, n1 + i + 1, n1 + n2, m_SecondSquaredDistances.memptr() + this->GetPackedRowOffset(i, n2));
+    }
+    catch (std::exception &e)
+    {
+      errorHandler.Store(n1 + i, e);
+    }
+  }
+
+  errorHandler.Rethrow();
+
+  double maximalSquaredDistance = 0.0;
+  if (m_FirstSquaredDistances.n_elem > 0)
+    maximalSquaredDistance = std::max(maximalSquaredDistance, arma::max(m_FirstSquaredDistances));
+  if (m_CrossSquaredDistances.n_elem > 0)
+    maximalSquaredDistance = std::max(maximalSquaredDistance, arma::max(m_CrossSquaredDistances));
+  if (m_SecondSquaredDistances.n_elem > 0)
+    maximalSquaredDistance = std::max(maximalSquaredDistance, arma::max(m_SecondSquaredDistances));
+  m_MaximalDistance = std::sqrt(maximalSquaredDistance);
+
+  m_Profiler.Stop(EvaluationProfiler::InputsPhase);
+
+  // Rcpp::Rcout << "Domain Dimension: " << m_DomainDimension << std::endl;
+  // Rcpp::Rcout << "Domain Volume: " << m_DomainVolume << std::endl;
+  // Rcpp::Rcout << "Sample size: " << m_SampleSize << std::endl;
+  // Rcpp::Rcout << "Point labels: " << m_PointLabels.as_row() << std::endl;
+}
+
+double BaseLogLikelihood::ComputeCutoffRadius(const arma::vec &lb, const arma::vec &ub)
+{
+  // The widest marginal kernel is the one of the largest alpha with an
+  // amplitude below 1 at the observed intensities.
+  double alpha = 0.0;
+  if (m_FirstSampleSize > 0)
+    alpha = std::max(alpha, this->RetrieveAlphaFromParameters(1.0, (double)m_FirstSampleSize / m_DomainVolume, m_DomainDimension));
+  if (m_SecondSampleSize > 0)
+    alpha = std::max(alpha, this->RetrieveAlphaFromParameters(1.0, (double)m_SecondSampleSize / m_DomainVolume, m_DomainDimension));
+
+  double maximalRadius = arma::min(ub - lb);
+  if (m_UsePeriodicDomain)
+    maximalRadius /= 2.0;
+
+  if (!(alpha > 0.0))
+    return maximalRadius;
+
+  // The kernel is scanned outwards. Oscillating kernels, such as the Bessel
+  // ones, cross the threshold several times, so that the scan only stops
+  // once the kernel has stayed below it over several multiples of alpha.
+  double thresholdValue = m_SparseTolerance * std::abs(this->EvaluateSpatialKernel(0.0, alpha));
+  double radiusStep = alpha / 16.0;
+  double resVal = 0.0;
+
+  for (double radius = radiusStep;radius < maximalRadius;radius += radiusStep)
+  {
+    if (std::abs(this->EvaluateSpatialKernel(radius * radius, alpha)) > thresholdValue)
+      resVal = radius;
+    else if (radius > resVal + 8.0 * alpha)
+      break;
+  }
+
+  return std::min(resVal + radiusStep, maximalRadius);
+}
+
+void BaseLogLikelihood::ComputeNeighbourPairs(const arma::mat &points, const arma::vec &lb, const arma::vec &ub)
+{
+  m_NeighbourRadius = (m_CutoffRadius > 0.0) ? m_CutoffRadius : this->ComputeCutoffRadius(lb, ub);
+
+  CellList cellList;
+  cellList.SetDomain(lb, ub);
+  cellList.SetUsePeriodicDomain(m_UsePeriodicDomain);
+  cellList.Build(points, m_NeighbourRadius);
+
+  // Pairs are sorted by point so that rows can be processed independently.
+  std::vector<std::pair<unsigned int, unsigned int> > workPairs;
+  std::vector<double> workSquaredDistances;
+  auto pairFunction = [&](const unsigned int i, const unsigned int j, const std::vector<double> &difference)
+  {
+    double sqDist = 0.0;
+    for (unsigned int l = 0;l < difference.size();++l)
+      sqDist += difference[l] * difference[l];
+
+    workPairs.push_back(std::make_pair(i, j));
+    workSquaredDistances.push_back(sqDist);
+  };
+
+  cellList.VisitPairs(points, pairFunction);
+
+  unsigned int numPairs = workPairs.size();
+  std::vector<unsigned int> sortedPairs(numPairs);
+  for (unsigned int p = 0;p < numPairs;++p)
+    sortedPairs[p] = p;
+  std::sort(sortedPairs.begin(), sortedPairs.end(), [&](const unsigned int a, const unsigned int b) {
+    return workPairs[a] < workPairs[b];
+  });
+
+  m_NeighbourStarts.assign(m_SampleSize + 1, 0);
+  m_NeighbourIndices.resize(numPairs);
+  m_NeighbourSquaredDistances.set_size(numPairs);
+  std::vector<unsigned int> patternPairs(2 * numPairs);
+
+  for (unsigned int p = 0;p < numPairs;++p)
+  {
+    const std::pair<unsigned int, unsigned int> &workPair = workPairs[sortedPairs[p]];
+    ++m_NeighbourStarts[workPair.first + 1];
+    m_NeighbourIndices[p] = workPair.second;
+    m_NeighbourSquaredDistances[p] = workSquaredDistances[sortedPairs[p]];
+    patternPairs[2 * p] = workPair.first;
+    patternPairs[2 * p + 1] = workPair.second;
+  }
+
+  m_MaximalNumberOfNeighbours = 0;
+  for (unsigned int i = 0;i < m_SampleSize;++i)
+  {
+    m_MaximalNumberOfNeighbours = std::max(m_MaximalNumberOfNeighbours, m_NeighbourStarts[i + 1]);
+    m_NeighbourStarts[i + 1] += m_NeighbourStarts[i];
+  }
+
+  // The stochastic log-determinant only needs products with the L-matrix,
+  // so the envelope of the factorization is not allocated.
+  if (m_NumberOfProbes > 0)
+  {
+    m_NeighbourPositions.clear();
+    m_DiagonalPositions.clear();
+    m_SparseFactor.Analyze(0, std::vector<unsigned int>());
+    return;
+  }
+
+  m_SparseFactor.Analyze(m_SampleSize, patternPairs);
+
+  m_DiagonalPositions.resize(m_SampleSize);
+  m_NeighbourPositions.resize(numPairs);
+  for (unsigned int i = 0;i < m_SampleSize;++i)
+  {
+    m_DiagonalPositions[i] = m_SparseFactor.GetPosition(i, i);
+    for (unsigned int p = m_NeighbourStarts[i];p < m_NeighbourStarts[i + 1];++p)
+      m_NeighbourPositions[p] = m_SparseFactor.GetPosition(i, m_NeighbourIndices[p]);
+  }
+}
+
+void BaseLogLikelihood::SetNumberOfProbes(const unsigned int n)
+{
+  m_NumberOfProbes = n;
+  if (n > 0)
+    m_StochasticEstimator.SetNumberOfProbes(n);
+  this->ClearCache();
+  m_Modified = true;
+}
+
+void BaseLogLikelihood::SetProbeSeed(const uint64_t x)
+{
+  m_StochasticEstimator.SetSeed(x);
+  m_ProbeSeed = x;
+  this->ClearCache();
+  m_Modified = true;
+}
+
+void BaseLogLikelihood::SetProfiling(const bool x)
+{
+  m_Profiler.SetEnabled(x);
+  m_Profiler.Reset();
+}
+
+void BaseLogLikelihood::SetSinglePrecision(const bool x)
+{
+  m_UseSinglePrecision = x;
+  this->ClearCache();
+  m_Modified = true;
+}
+
+void BaseLogLikelihood::SetNumberOfCorrectionProbes(const unsigned int n)
+{
+  m_NumberOfCorrectionProbes = (n > 0) ? n : 1;
+  this->ClearCache();
+  m_Modified = true;
+}
+
+void BaseLogLikelihood::SetBesselJRatioTolerance(const double x)
+{
+  m_BesselJRatioTolerance = (arma::is_finite(x)) ? x : 0.0;
+
+  // The table depends on the domain dimension and is otherwise built when
+  // setting the inputs.
+  if (m_PointLabels.is_empty())
+    m_BesselJRatioTable.Clear();
+  else if (m_BesselJRatioTolerance > 0.0)
+    m_BesselJRatioTable.Build((double)m_DomainDimension / 2.0, m_BesselJRatioTolerance);
+  else
+    m_BesselJRatioTable.Clear();
+
+  this->ClearCache();
+  m_Modified = true;
+}
+
+void BaseLogLikelihood::GetParameterBounds(arma::vec &lowerBounds, arma::vec &upperBounds)
+{
+  unsigned int numParams = this->GetNumberOfParameters();
+  lowerBounds.set_size(numParams);
+  upperBounds.set_size(numParams);
+  lowerBounds.fill(m_Epsilon);
+  upperBounds.fill(1.0);
+
+  // Amplitudes must stay below 1 and the normalized cross amplitude may
+  // vanish
+  upperBounds[0] = 1.0 - m_Epsilon;
+  upperBounds[1] = 1.0 - m_Epsilon;
+  lowerBounds[2] = 0.0;
+  upperBounds[2] = 1.0 - m_Epsilon;
+}
+
+arma::mat BaseLogLikelihood::GetInitialPoint()
+{
+  // Center of the parameter box, which is always a valid model
+  arma::vec lowerBounds, upperBounds;
+  this->GetParameterBounds(lowerBounds, upperBounds);
+
+  arma::mat params(this->GetNumberOfParameters(), 1);
+  for (unsigned int i = 0;i < params.n_elem;++i)
+    params[i] = (lowerBounds[i] + upperBounds[i]) / 2.0;
+
+  return params;
+}
+
+unsigned int BaseLogLikelihood::GetNumberOfParameters()
+{
+  unsigned int numParams = 4;
+
+  if (m_EstimateIntensities)
+    numParams += 2;
+
+  return numParams;
+}
+
+double BaseLogLikelihood::GetUnitBallVolume()
+{
+  double order = (double)m_DomainDimension / 2.0;
+  return std::pow(M_PI, order) / boost::math::tgamma(1.0 + order);
+}
+
+double BaseLogLikelihood::GetIntegral()
+{
+  double resVal = 0.0;
+  arma::vec workGradient;
+
+  if (!this->GetAnalyticIntegral(resVal, workGradient))
+    this->IntegrateSpectralDensity(resVal, workGradient);
+
+  // Partial derivatives w.r.t. the natural parameters (k1, alpha1, k2,
+  // alpha2, k12, 1 / alpha12)
+  m_GradientIntegral = workGradient;
+
+  return resVal;
+}
+
+template <class TMatrix>
+void BaseLogLikelihood::BuildLMatrix(TMatrix &lMatrix)
+{
+  m_Profiler.Start(EvaluationProfiler::AssemblyPhase);
+  lMatrix.set_size(m_SampleSize, m_SampleSize);
+  unsigned int n1 = m_FirstSampleSize;
+  unsigned int n2 = m_SecondSampleSize;
+
+  // The diagonal is constant within each label
+  double firstDiagonal = this->EvaluateLEntry(0.0, 0);
+  double secondDiagonal = this->EvaluateLEntry(0.0, 2);
+
+  ParallelErrorHandler errorHandler;
+  ThreadWorkspace rowWorkspace(m_NumberOfThreads, n1 + n2);
+  ThreadWorkspace workWorkspace(m_NumberOfThreads, n1 + n2);
+
+  // Each row is split into spans of pairs sharing a kernel, which are
+  // evaluated in a single call. Entries are computed independently of one
+  // another, hence deterministic whatever the number of threads.
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(m_NumberOfThreads)
+#endif
+  for (unsigned int i = 0;i < n1;++i)
+  {
+    try
+    {
+      double *rowValues = rowWorkspace.GetValues();
+      double *workValues = workWorkspace.GetValues();
+      unsigned int numValues = n1 - i - 1;
+      const double *sqDistances = m_FirstSquaredDistances.memptr() + this->GetPackedRowOffset(i, n1);
+      this->EvaluateLEntries(sqDistances, numValues, 0, rowValues, workValues);
+      lMatrix(i, i) = firstDiagonal;
+
+      for (unsigned int k = 0;k < numValues;++k)
+      {
+        lMatrix(i, i + 1 + k) = rowValues[k];
+        lMatrix(i + 1 + k, i) = rowValues[k];
+      }
+
+      sqDistances = m_CrossSquaredDistances.memptr() + (arma::uword)i * n2;
+      this->EvaluateLEntries(sqDistances, n2, 1, rowValues, workValues);
+
+      for (unsigned int j = 0;j < n2;++j)
+      {
+        lMatrix(i, n1 + j) = rowValues[j];
+        lMatrix(n1 + j, i) = rowValues[j];
+      }
+    }
+    catch (std::exception &e)
+    {
+      errorHandler.Store(i, e);
+    }
+  }
+
+  errorHandler.Rethrow();
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(m_NumberOfThreads)
+#endif
+  for (unsigned int i = 0;i < n2;++i)
+  {
+    try
+    {
+      double *rowValues = rowWorkspace.GetValues();
+      double *workValues = workWorkspace.GetValues();
+      unsigned int numValues = n2 - i - 1;
+      const double *sqDistances = m_SecondSquaredDistances.memptr() + this->GetPackedRowOffset(i, n2);
+      this->EvaluateLEntries(sqDistances, numValues, 2, rowValues, workValues);
+      lMatrix(n1 + i, n1 + i) = secondDiagonal;
+
+      for (unsigned int k = 0;k < numValues;++k)
+      {
+        lMatrix(n1 + i, n1 + i + 1 + k) = rowValues[k];
+        lMatrix(n1 + i + 1 + k, n1 + i) = rowValues[k];
+      }
+    }
+    catch (std::exception &e)
+    {
+      errorHandler.Store(n1 + i, e);
+    }
+  }
+
+  errorHandler.Rethrow();
+
+  m_Profiler.Stop(EvaluationProfiler::AssemblyPhase);
+}
+
+template void BaseLogLikelihood::BuildLMatrix<arma::mat>(arma::mat &lMatrix);
+template void BaseLogLikelihood::BuildLMatrix<arma::fmat>(arma::fmat &lMatrix);
+
+double BaseLogLikelihood::EvaluateLEntry(const double sqDist, const unsigned int labelPair)
+{
+  double resVal = 0.0;
+  double workValue = 0.0;
+  this->EvaluateLEntries(&sqDist, 1, labelPair, &resVal, &workValue);
+  return resVal;
+}
+
+void BaseLogLikelihood::EvaluateNeighbourLEntries(const unsigned int i, double *values, double *workValues)
+{
+  unsigned int firstIndex = m_NeighbourStarts[i];
+  unsigned int lastIndex = m_NeighbourStarts[i + 1];
+  const double *sqDistances = m_NeighbourSquaredDistances.memptr();
+
+  if (i >= m_FirstSampleSize)
+  {
+    this->EvaluateLEntries(sqDistances + firstIndex, lastIndex - firstIndex, 2, values, workValues);
+    return;
+  }
+
+  // Neighbours are sorted, those of the first label come first
+  unsigned int splitIndex = std::lower_bound(m_NeighbourIndices.begin() + firstIndex, m_NeighbourIndices.begin() + lastIndex, m_FirstSampleSize) - m_NeighbourIndices.begin();
+  this->EvaluateLEntries(sqDistances + firstIndex, splitIndex - firstIndex, 0, values, workValues);
+  this->EvaluateLEntries(sqDistances + splitIndex, lastIndex - splitIndex, 1, values + (splitIndex - firstIndex), workValues);
+}
+
+void BaseLogLikelihood::BuildSparseLMatrix()
+{
+  // Entries beyond the cutoff radius are dropped. The positions of the
+  // others in the envelope are known since SetInputs() and distinct, so that
+  // rows can be filled concurrently.
+  m_Profiler.Start(EvaluationProfiler::AssemblyPhase);
+  m_SparseFactor.ResetValues();
+  double *values = m_SparseFactor.GetValues();
+  double firstDiagonal = this->EvaluateLEntry(0.0, 0);
+  double secondDiagonal = this->EvaluateLEntry(0.0, 2);
+
+  ParallelErrorHandler errorHandler;
+  ThreadWorkspace rowWorkspace(m_NumberOfThreads, m_MaximalNumberOfNeighbours);
+  ThreadWorkspace workWorkspace(m_NumberOfThreads, m_MaximalNumberOfNeighbours);
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic, 64) num_threads(m_NumberOfThreads)
+#endif
+  for (unsigned int i = 0;i < m_SampleSize;++i)
+  {
+    try
+    {
+      unsigned int firstIndex = m_NeighbourStarts[i];
+      unsigned int numValues = m_NeighbourStarts[i + 1] - firstIndex;
+      double *rowValues = rowWorkspace.GetValues();
+      this->EvaluateNeighbourLEntries(i, rowValues, workWorkspace.GetValues());
+      values[m_DiagonalPositions[i]] = (i < m_FirstSampleSize) ? firstDiagonal : secondDiagonal;
+
+      for (unsigned int k = 0;k < numValues;++k)
+        values[m_NeighbourPositions[firstIndex + k]] = rowValues[k];
+    }
+    catch (std::exception &e)
+    {
+      errorHandler.Store(i, e);
+    }
+  }
+
+  errorHandler.Rethrow();
+
+  m_Profiler.Stop(EvaluationProfiler::AssemblyPhase);
+}
+
+double BaseLogLikelihood::GetSparseLogDeterminant(const bool computeGradient)
+{
+  this->BuildSparseLMatrix();
+
+  m_GradientLogDeterminant.set_size(6);
+  m_GradientLogDeterminant.fill(0.0);
+
+  // Unlike the dense path, there is no fallback when the truncated L-matrix
+  // is not positive definite: the parameters are then rejected.
+  if (!m_SparseFactor.Factorize())
+  {
+    m_ValidLogDeterminant = false;
+    return 0.0;
+  }
+
+  double resVal = m_SparseFactor.GetLogDeterminant();
+
+  if (!computeGradient)
+    return resVal;
+
+  // trace(inv(L) * dL) only involves the entries of inv(L) in the pattern of
+  // the truncated L-matrix, which the selected inversion provides.
+  m_SparseFactor.Invert();
+  const double *inverseValues = m_SparseFactor.GetValues();
+
+  arma::mat workSums(6, m_SampleSize);
+  workSums.fill(0.0);
+
+  double firstDiagonal[6], secondDiagonal[6];
+  this->EvaluateLDerivatives(0.0, 0, firstDiagonal);
+  this->EvaluateLDerivatives(0.0, 2, secondDiagonal);
+
+  ParallelErrorHandler errorHandler;
+  unsigned int maximalNumberOfPairs = this->GetMaximalNumberOfRowPairs();
+  ThreadWorkspace derivativeWorkspace(m_NumberOfThreads, 6 * maximalNumberOfPairs);
+  ThreadWorkspace workWorkspace(m_NumberOfThreads, 4 * maximalNumberOfPairs);
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic, 64) num_threads(m_NumberOfThreads)
+#endif
+  for (unsigned int i = 0;i < m_SampleSize;++i)
+  {
+    try
+    {
+      double *rowSums = workSums.colptr(i);
+      const double *diagonalDerivatives = (i < m_FirstSampleSize) ? firstDiagonal : secondDiagonal;
+      unsigned int numPairs = this->GetNumberOfRowPairs(i);
+      double *derivatives = derivativeWorkspace.GetValues();
+      this->EvaluateRowLDerivatives(i, derivatives, workWorkspace.GetValues());
+
+      for (unsigned int k = 0;k < 6;++k)
+        rowSums[k] += inverseValues[m_DiagonalPositions[i]] * diagonalDerivatives[k];
+
+      for (unsigned int p = 0;p < numPairs;++p)
+      {
+        const double *entryDerivatives = derivatives + 6 * p;
+        double inverseValue = inverseValues[m_NeighbourPositions[m_NeighbourStarts[i] + p]];
+        for (unsigned int k = 0;k < 6;++k)
+          rowSums[k] += 2.0 * inverseValue * entryDerivatives[k];
+      }
+    }
+    catch (std::exception &e)
+    {
+      errorHandler.Store(i, e);
+    }
+  }
+
+  errorHandler.Rethrow();
+
+  for (unsigned int i = 0;i < m_SampleSize;++i)
+  {
+    for (unsigned int k = 0;k < 6;++k)
+      m_GradientLogDeterminant[k] += workSums(k, i);
+  }
+
+  return resVal;
+}
+
+void BaseLogLikelihood::MultiplySparseLMatrix(const arma::mat &x, arma::mat &y)
+{
+  double firstDiagonal = this->EvaluateLEntry(0.0, 0);
+  double secondDiagonal = this->EvaluateLEntry(0.0, 2);
+  y.set_size(x.n_rows, x.n_cols);
+
+  ParallelErrorHandler errorHandler;
+
+  // Each vector of the block is handled by a single thread, which keeps the
+  // sums in a fixed order.
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) num_threads(m_NumberOfThreads)
+#endif
+  for (unsigned int c = 0;c < x.n_cols;++c)
+  {
+    try
+    {
+      const double *inputValues = x.colptr(c);
+      double *outputValues = y.colptr(c);
+
+      for (unsigned int i = 0;i < m_SampleSize;++i)
+        outputValues[i] = ((i < m_FirstSampleSize) ? firstDiagonal : secondDiagonal) * inputValues[i];
+
+      for (unsigned int i = 0;i < m_SampleSize;++i)
+      {
+        for (unsigned int p = m_NeighbourStarts[i];p < m_NeighbourStarts[i + 1];++p)
+        {
+          unsigned int j = m_NeighbourIndices[p];
+          outputValues[i] += m_NeighbourValues[p] * inputValues[j];
+          outputValues[j] += m_NeighbourValues[p] * inputValues[i];
+        }
+      }
+    }
+    catch (std::exception &e)
+    {
+      errorHandler.Store(c, e);
+    }
+  }
+
+  errorHandler.Rethrow();
+}
+
+double BaseLogLikelihood::GetStochasticLogDeterminant(const bool computeGradient)
+{
+  m_GradientLogDeterminant.set_size(6);
+  m_GradientLogDeterminant.fill(0.0);
+
+  bool validEstimate = false;
+
+  if (m_UseSparseLMatrix)
+  {
+    m_Profiler.Start(EvaluationProfiler::AssemblyPhase);
+    m_NeighbourValues.set_size(m_NeighbourIndices.size());
+
+    ParallelErrorHandler errorHandler;
+    ThreadWorkspace workWorkspace(m_NumberOfThreads, m_MaximalNumberOfNeighbours);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 64) num_threads(m_NumberOfThreads)
+#endif
+    for (unsigned int i = 0;i < m_SampleSize;++i)
+    {
+      try
+      {
+        this->EvaluateNeighbourLEntries(i, m_NeighbourValues.memptr() + m_NeighbourStarts[i], workWorkspace.GetValues());
+      }
+      catch (std::exception &e)
+      {
+        errorHandler.Store(i, e);
+      }
+    }
+
+    errorHandler.Rethrow();
+
+    m_Profiler.Stop(EvaluationProfiler::AssemblyPhase);
+
+    auto multiplyFunction = [this](const arma::mat &x, arma::mat &y) {this->MultiplySparseLMatrix(x, y);};
+    validEstimate = m_StochasticEstimator.Compute(m_SampleSize, multiplyFunction);
+  }
+  else
+  {
+    // Entries of the dense L-matrix are computed on the fly at each product
+    // rather than stored, which trades n^2 storage for their evaluation at
+    // every step. Probes are transposed so that the values at a point are
+    // contiguous.
+    arma::mat inputValues, outputValues;
+    auto multiplyFunction = [this, &inputValues, &outputValues](const arma::mat &x, arma::mat &y)
+    {
+      inputValues = x.t();
+      this->MultiplyDenseLMatrix(inputValues, outputValues);
+      y = outputValues.t();
+    };
+    validEstimate = m_StochasticEstimator.Compute(m_SampleSize, multiplyFunction);
+  }
+
+  if (!validEstimate)
+  {
+    m_ValidLogDeterminant = false;
+    return 0.0;
+  }
+
+  m_LogDeterminantError = m_StochasticEstimator.GetStandardError();
+  double resVal = m_StochasticEstimator.GetLogDeterminant();
+
+  if (!computeGradient)
+    return resVal;
+
+  // Hutchinson estimator trace(inv(L) * dL) ~ mean of u^T dL z over the
+  // probes z, with u = inv(L) z from the same iterations. Since u is only
+  // approximate after the fixed number of steps, this is not the derivative
+  // of the quadrature above. Probe values are transposed so that those of a
+  // point are contiguous.
+  arma::mat probeValues = m_StochasticEstimator.GetProbes().t();
+  arma::mat solutionValues = m_StochasticEstimator.GetSolutions().t();
+  unsigned int numProbes = probeValues.n_rows;
+
+  arma::mat workSums(6, m_SampleSize);
+  workSums.fill(0.0);
+
+  double firstDiagonal[6], secondDiagonal[6];
+  this->EvaluateLDerivatives(0.0, 0, firstDiagonal);
+  this->EvaluateLDerivatives(0.0, 2, secondDiagonal);
+
+  ParallelErrorHandler errorHandler;
+  unsigned int maximalNumberOfPairs = this->GetMaximalNumberOfRowPairs();
+  ThreadWorkspace derivativeWorkspace(m_NumberOfThreads, 6 * maximalNumberOfPairs);
+  ThreadWorkspace workWorkspace(m_NumberOfThreads, 4 * maximalNumberOfPairs);
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic, 64) num_threads(m_NumberOfThreads)
+#endif
+  for (unsigned int i = 0;i < m_SampleSize;++i)
+  {
+    try
+    {
+      double *rowSums = workSums.colptr(i);
+      const double *firstProbes = probeValues.colptr(i);
+      const double *firstSolutions = solutionValues.colptr(i);
+      const double *diagonalDerivatives = (i < m_FirstSampleSize) ? firstDiagonal : secondDiagonal;
+      unsigned int numPairs = this->GetNumberOfRowPairs(i);
+      double *derivatives = derivativeWorkspace.GetValues();
+      this->EvaluateRowLDerivatives(i, derivatives, workWorkspace.GetValues());
+      const double *entryDerivatives = derivatives;
+
+      double workValue = 0.0;
+      for (unsigned int p = 0;p < numProbes;++p)
+        workValue += firstSolutions[p] * firstProbes[p];
+
+      for (unsigned int k = 0;k < 6;++k)
+        rowSums[k] += workValue * diagonalDerivatives[k];
+
+      auto pairFunction = [&](const unsigned int j, const double sqDist, const unsigned int labelPair)
+      {
+        const double *secondProbes = probeValues.colptr(j);
+        const double *secondSolutions = solutionValues.colptr(j);
+        double pairValue = 0.0;
+        for (unsigned int p = 0;p < numProbes;++p)
+          pairValue += firstSolutions[p] * secondProbes[p] + secondSolutions[p] * firstProbes[p];
+
+        for (unsigned int k = 0;k < 6;++k)
+          rowSums[k] += pairValue * entryDerivatives[k];
+        entryDerivatives += 6;
+      };
+
+      this->VisitRowPairs(i, pairFunction);
+    }
+    catch (std::exception &e)
+    {
+      errorHandler.Store(i, e);
+    }
+  }
+
+  errorHandler.Rethrow();
+
+  for (unsigned int i = 0;i < m_SampleSize;++i)
+  {
+    for (unsigned int k = 0;k < 6;++k)
+      m_GradientLogDeterminant[k] += workSums(k, i);
+  }
+
+  m_GradientLogDeterminant /= (double)numProbes;
+
+  return resVal;
+}
+
+void BaseLogLikelihood::ClearCache()
+{
+  m_EvaluationCache.Clear();
+  this->ClearLFunctions();
+}
+
+void BaseLogLikelihood::EvaluateLDerivatives(const double sqDist, const unsigned int labelPair, double *derivatives)
+{
+  double workValues[4];
+  this->EvaluateLDerivativeEntries(&sqDist, 1, labelPair, derivatives, workValues);
+}
+
+unsigned int BaseLogLikelihood::GetNumberOfRowPairs(const unsigned int i) const
+{
+  if (m_UseSparseLMatrix)
+    return m_NeighbourStarts[i + 1] - m_NeighbourStarts[i];
+
+  return m_SampleSize - i - 1;
+}
 
-  for (unsigned int i = 0;i < n;++i)
+unsigned int BaseLogLikelihood::GetMaximalNumberOfRowPairs() const
+{
+  if (m_UseSparseLMatrix)
+    return m_MaximalNumberOfNeighbours;
+
+  return (m_SampleSize > 0) ? m_SampleSize - 1 : 0;
+}
+
+void BaseLogLikelihood::EvaluateRowLDerivatives(const unsigned int i, double *derivatives, double *workValues)
+{
+  unsigned int n1 = m_FirstSampleSize;
+  unsigned int n2 = m_SecondSampleSize;
+
+  if (m_UseSparseLMatrix)
   {
-    workList = m_Neighborhood;
-    m_Neighborhood.clear();
+    unsigned int firstIndex = m_NeighbourStarts[i];
+    unsigned int lastIndex = m_NeighbourStarts[i + 1];
+    const double *sqDistances = m_NeighbourSquaredDistances.memptr();
 
-    for (unsigned int j = 0;j < workList.size();++j)
+    if (i >= n1)
     {
-      for (int k = -1;k <= 1;++k)
-      {
-        workVec = workList[j];
-        workVec[i] += k;
-        m_Neighborhood.push_back(workVec);
-      }
+      this->EvaluateLDerivativeEntries(sqDistances + firstIndex, lastIndex - firstIndex, 2, derivatives, workValues);
+      return;
     }
+
+    // Neighbours are sorted, those of the first label come first
+    unsigned int splitIndex = std::lower_bound(m_NeighbourIndices.begin() + firstIndex, m_NeighbourIndices.begin() + lastIndex, n1) - m_NeighbourIndices.begin();
+    this->EvaluateLDerivativeEntries(sqDistances + firstIndex, splitIndex - firstIndex, 0, derivatives, workValues);
+    this->EvaluateLDerivativeEntries(sqDistances + splitIndex, lastIndex - splitIndex, 1, derivatives + 6 * (splitIndex - firstIndex), workValues);
+    return;
+  }
+
+  if (i >= n1)
+  {
+    this->EvaluateLDerivativeEntries(m_SecondSquaredDistances.memptr() + this->GetPackedRowOffset(i - n1, n2), n1 + n2 - i - 1, 2, derivatives, workValues);
+    return;
   }
+
+  this->EvaluateLDerivativeEntries(m_FirstSquaredDistances.memptr() + this->GetPackedRowOffset(i, n1), n1 - i - 1, 0, derivatives, workValues);
+  this->EvaluateLDerivativeEntries(m_CrossSquaredDistances.memptr() + (arma::uword)i * n2, n2, 1, derivatives + 6 * (n1 - i - 1), workValues);
 }
 
-std::vector<arma::rowvec> BaseLogLikelihood::GetTrialVectors(const arma::rowvec &x, const arma::vec &lb, const arma::vec &ub)
+void BaseLogLikelihood::GetParameterJacobian(arma::mat &jacobian)
 {
-  unsigned int numTrials = m_Neighborhood.size();
-  std::vector<arma::rowvec> trialVectors(numTrials);
-  std::vector<int> workNeighborhood;
-  arma::rowvec workVector;
-
-  for (unsigned int i = 0;i < numTrials;++i)
+  // Derivatives of the natural parameters (k1, alpha1, k2, alpha2, k12,
+  // 1 / alpha12) w.r.t. the optimizer parameters (k1, k2, k12star, beta12,
+  // [alpha1star, alpha2star]), stored column-wise.
+  jacobian.set_size(6, this->GetNumberOfParameters());
+  jacobian.fill(0.0);
+  jacobian(0, 0) = 1.0;
+  jacobian(2, 1) = 1.0;
+
+  // k12 = k12star * sqrt(min(k1 * k2, (1 - k1) * (1 - k2)))
+  double firstBound = m_FirstAmplitude * m_SecondAmplitude;
+  double secondBound = (1.0 - m_FirstAmplitude) * (1.0 - m_SecondAmplitude);
+  double upperBound = std::sqrt(std::max(std::min(firstBound, secondBound), 0.0));
+
+  if (upperBound > 0.0)
   {
-    workNeighborhood = m_Neighborhood[i];
-    workVector = x;
-    for (unsigned int j = 0;j < m_DomainDimension;++j)
-      workVector[j] += (double)workNeighborhood[j] * (ub[j] - lb[j]);
-    trialVectors[i] = workVector;
+    double workValue = m_NormalizedCrossAmplitude / (2.0 * upperBound);
+
+    // Both branches are averaged where the minimum is not differentiable,
+    // e.g. at the initial point
+    double firstWeight = (firstBound < secondBound) ? 1.0 : 0.0;
+    if (firstBound == secondBound)
+      firstWeight = 0.5;
+
+    jacobian(4, 0) = workValue * (firstWeight * m_SecondAmplitude - (1.0 - firstWeight) * (1.0 - m_SecondAmplitude));
+    jacobian(4, 1) = workValue * (firstWeight * m_FirstAmplitude - (1.0 - firstWeight) * (1.0 - m_FirstAmplitude));
   }
 
-  return trialVectors;
+  jacobian(4, 2) = upperBound;
+
+  // 1 / alpha12 = beta12 / lb(alpha1, alpha2)
+  double lowerBound = this->GetCrossAlphaLowerBound();
+  double firstDerivative = 0.0, secondDerivative = 0.0;
+  this->GetCrossAlphaLowerBoundDerivatives(firstDerivative, secondDerivative);
+  jacobian(5, 3) = 1.0 / lowerBound;
+  firstDerivative *= -m_CrossBeta / (lowerBound * lowerBound);
+  secondDerivative *= -m_CrossBeta / (lowerBound * lowerBound);
+
+  if (m_EstimateIntensities)
+  {
+    jacobian(1, 4) = m_AlphaUpperBound;
+    jacobian(3, 5) = m_AlphaUpperBound;
+    jacobian(5, 4) = firstDerivative * m_AlphaUpperBound;
+    jacobian(5, 5) = secondDerivative * m_AlphaUpperBound;
+  }
+  else
+  {
+    // With fixed intensities, alpha is proportional to k^(1 / d) in all
+    // models
+    double firstAlphaDerivative = m_FirstAlpha / ((double)m_DomainDimension * m_FirstAmplitude);
+    double secondAlphaDerivative = m_SecondAlpha / ((double)m_DomainDimension * m_SecondAmplitude);
+    jacobian(1, 0) = firstAlphaDerivative;
+    jacobian(3, 1) = secondAlphaDerivative;
+    jacobian(5, 0) = firstDerivative * firstAlphaDerivative;
+    jacobian(5, 1) = secondDerivative * secondAlphaDerivative;
+  }
 }
 
-void BaseLogLikelihood::SetInputs(
-    const arma::mat &points,
-    const arma::uvec &labels,
-    const arma::vec &lb,
-    const arma::vec &ub)
+void BaseLogLikelihood::MultiplyDenseLMatrix(const arma::mat &x, arma::mat &y)
 {
-  m_DomainDimension = points.n_cols;
-  m_SampleSize = points.n_rows;
-  m_PointLabels = labels;
-  m_DomainVolume = 1.0;
-  for (unsigned int i = 0;i < m_DomainDimension;++i)
-    m_DomainVolume *= (ub[i] - lb[i]);
-
-  this->SetNeighborhood(m_DomainDimension);
-  m_DistanceMatrix.set_size(m_SampleSize, m_SampleSize);
-  m_DistanceMatrix.fill(0.0);
-  std::vector<arma::rowvec> trialVectors;
-  arma::rowvec workVec1, workVec2;
+  unsigned int n1 = m_FirstSampleSize;
+  unsigned int n2 = m_SecondSampleSize;
+  unsigned int numVectors = x.n_rows;
+  double firstDiagonal = this->EvaluateLEntry(0.0, 0);
+  double secondDiagonal = this->EvaluateLEntry(0.0, 2);
+  y.set_size(x.n_rows, x.n_cols);
 
   for (unsigned int i = 0;i < m_SampleSize;++i)
   {
-    workVec1 = points.row(i);
+    double *outputValues = y.colptr(i);
+    const double *inputValues = x.colptr(i);
+    double diagonalValue = (i < n1) ? firstDiagonal : secondDiagonal;
+    for (unsigned int c = 0;c < numVectors;++c)
+      outputValues[c] = diagonalValue * inputValues[c];
+  }
 
-    if (m_UsePeriodicDomain)
-      trialVectors = this->GetTrialVectors(workVec1, lb, ub);
+  // Entries L_ij, j > i, are evaluated once by spans for a block of rows and
+  // kept in blockValues(j, i - firstRow). They are then added to y_i by rows
+  // and to y_j by columns in two separate loops, each output being summed by
+  // a single thread in a fixed order. The block size does not depend on the
+  // number of threads so that neither does the result.
+  const unsigned int blockSize = 64;
+  arma::mat blockValues(m_SampleSize, std::min(blockSize, m_SampleSize));
 
-    for (unsigned int j = i + 1;j < m_SampleSize;++j)
-    {
-      workVec2 = points.row(j);
+  ParallelErrorHandler errorHandler;
+  ThreadWorkspace workWorkspace(m_NumberOfThreads, m_SampleSize);
 
-      double workDistance = 0.0;
+  for (unsigned int firstRow = 0;firstRow < m_SampleSize;firstRow += blockSize)
+  {
+    unsigned int lastRow = std::min(firstRow + blockSize, m_SampleSize);
 
-      if (m_UsePeriodicDomain)
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) num_threads(m_NumberOfThreads)
+#endif
+    for (unsigned int i = firstRow;i < lastRow;++i)
+    {
+      try
       {
-        for (unsigned int k = 0;k < trialVectors.size();++k)
+        double *workValues = workWorkspace.GetValues();
+        double *rowValues = blockValues.colptr(i - firstRow);
+
+        if (i < n1)
+        {
+          unsigned int numValues = n1 - i - 1;
+          this->EvaluateLEntries(m_FirstSquaredDistances.memptr() + this->GetPackedRowOffset(i, n1), numValues, 0, rowValues + i + 1, workValues);
+          this->EvaluateLEntries(m_CrossSquaredDistances.memptr() + (arma::uword)i * n2, n2, 1, rowValues + n1, workValues);
+        }
+        else
+          this->EvaluateLEntries(m_SecondSquaredDistances.memptr() + this->GetPackedRowOffset(i - n1, n2), m_SampleSize - i - 1, 2, rowValues + i + 1, workValues);
+
+        double *outputValues = y.colptr(i);
+        for (unsigned int j = i + 1;j < m_SampleSize;++j)
         {
-          double testDistance = arma::norm(trialVectors[k] - workVec2);
-          if (testDistance < workDistance || k == 0)
-            workDistance = testDistance;
+          const double *otherValues = x.colptr(j);
+          for (unsigned int c = 0;c < numVectors;++c)
+            outputValues[c] += rowValues[j] * otherValues[c];
         }
       }
-      else
-        workDistance = arma::norm(workVec1 - workVec2);
+      catch (std::exception &e)
+      {
+        errorHandler.Store(i, e);
+      }
+    }
+
+    errorHandler.Rethrow();
 
-      m_DistanceMatrix(i, j) = workDistance;
-      m_DistanceMatrix(j, i) = workDistance;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(m_NumberOfThreads)
+#endif
+    for (unsigned int j = firstRow + 1;j < m_SampleSize;++j)
+    {
+      double *outputValues = y.colptr(j);
+      unsigned int endRow = std::min(lastRow, j);
+      for (unsigned int i = firstRow;i < endRow;++i)
+      {
+        double entryValue = blockValues(j, i - firstRow);
+        const double *otherValues = x.colptr(i);
+        for (unsigned int c = 0;c < numVectors;++c)
+          outputValues[c] += entryValue * otherValues[c];
+      }
     }
   }
+}
 
-  // Rcpp::Rcout << "Domain Dimension: " << m_DomainDimension << std::endl;
-  // Rcpp::Rcout << "Domain Volume: " << m_DomainVolume << std::endl;
-  // Rcpp::Rcout << "Sample size: " << m_SampleSize << std::endl;
-  // Rcpp::Rcout << "Point labels: " << m_PointLabels.as_row() << std::endl;
+static double GetSinglePrecisionDotProduct(const float *firstValues, const float *secondValues, const unsigned int n)
+{
+  // The sum is vectorized in a fixed order, which does not depend on the
+  // number of threads.
+  double resVal = 0.0;
+#ifdef _OPENMP
+  #pragma omp simd reduction(+:resVal)
+#endif
+  for (unsigned int k = 0;k < n;++k)
+    resVal += (double)firstValues[k] * (double)secondValues[k];
+  return resVal;
 }
 
-arma::mat BaseLogLikelihood::GetInitialPoint()
+static bool FactorizeSinglePrecision(arma::fmat &lMatrix, const unsigned int numThreads)
 {
-  arma::mat params(this->GetNumberOfParameters(), 1);
-  return params;
+  // Upper Cholesky factor R (L = R^T R) in place by blocks of rows, so that
+  // neither LAPACK nor BLAS is needed in single precision, which R does not
+  // ship. Each block of rows of R is computed from the updated block of L,
+  // whose trailing part is then updated by the products of columns of the
+  // block, contiguous in memory, once the whole block is known. Dot products
+  // are accumulated in double precision, each entry by a single thread.
+  // Returns false on a non-positive pivot.
+  const unsigned int blockSize = 64;
+  unsigned int n = lMatrix.n_rows;
+
+  for (unsigned int firstRow = 0;firstRow < n;firstRow += blockSize)
+  {
+    unsigned int lastRow = std::min(firstRow + blockSize, n);
+
+    for (unsigned int j = firstRow;j < lastRow;++j)
+    {
+      float *columnValues = lMatrix.colptr(j);
+      for (unsigned int i = firstRow;i < j;++i)
+      {
+        const float *otherValues = lMatrix.colptr(i);
+        double workValue = (double)columnValues[i] - GetSinglePrecisionDotProduct(otherValues + firstRow, columnValues + firstRow, i - firstRow);
+        columnValues[i] = (float)(workValue / (double)otherValues[i]);
+      }
+
+      double pivotValue = (double)columnValues[j] - GetSinglePrecisionDotProduct(columnValues + firstRow, columnValues + firstRow, j - firstRow);
+      if (!(pivotValue > 0.0))
+        return false;
+
+      columnValues[j] = (float)std::sqrt(pivotValue);
+    }
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) num_threads(numThreads)
+#endif
+    for (unsigned int j = lastRow;j < n;++j)
+    {
+      float *columnValues = lMatrix.colptr(j);
+      for (unsigned int i = firstRow;i < lastRow;++i)
+      {
+        const float *otherValues = lMatrix.colptr(i);
+        double workValue = (double)columnValues[i] - GetSinglePrecisionDotProduct(otherValues + firstRow, columnValues + firstRow, i - firstRow);
+        columnValues[i] = (float)(workValue / (double)otherValues[i]);
+      }
+    }
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) num_threads(numThreads)
+#endif
+    for (unsigned int j = lastRow;j < n;++j)
+    {
+      float *columnValues = lMatrix.colptr(j);
+      for (unsigned int i = lastRow;i <= j;++i)
+      {
+        const float *otherValues = lMatrix.colptr(i);
+        columnValues[i] -= (float)GetSinglePrecisionDotProduct(otherValues + firstRow, columnValues + firstRow, lastRow - firstRow);
+      }
+    }
+  }
+
+  return true;
 }
 
-unsigned int BaseLogLikelihood::GetNumberOfParameters()
+static void InvertSinglePrecisionFactor(arma::fmat &factorMatrix, const unsigned int numThreads)
 {
-  unsigned int numParams = 4;
+  // inv(L) = X X^T with X = inv(R) in place, with the factor R in the upper
+  // triangle. Row i of X solves R^T x = e_i and is stored as column i of the
+  // strictly lower triangle, its diagonal being kept aside, so that the
+  // entries of X X^T are dot products of contiguous columns. They are
+  // written in the upper triangle, then mirrored. Sums are accumulated in
+  // double precision.
+  unsigned int n = factorMatrix.n_rows;
+  arma::vec diagonalValues(n);
+  ThreadWorkspace solutionWorkspace(numThreads, n);
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(numThreads)
+#endif
+  for (unsigned int i = 0;i < n;++i)
+  {
+    double *solutionValues = solutionWorkspace.GetValues();
+    float *outputValues = factorMatrix.colptr(i);
+    solutionValues[i] = 1.0 / (double)outputValues[i];
 
-  if (m_EstimateIntensities)
-    numParams += 2;
+    for (unsigned int k = i + 1;k < n;++k)
+    {
+      const float *columnValues = factorMatrix.colptr(k);
+      double workValue = 0.0;
+      for (unsigned int m = i;m < k;++m)
+        workValue += (double)columnValues[m] * solutionValues[m];
+      solutionValues[k] = -workValue / (double)columnValues[k];
+    }
 
-  return numParams;
+    diagonalValues[i] = solutionValues[i];
+    for (unsigned int k = i + 1;k < n;++k)
+      outputValues[k] = (float)solutionValues[k];
+  }
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(numThreads)
+#endif
+  for (unsigned int j = 0;j < n;++j)
+  {
+    const float *columnValues = factorMatrix.colptr(j);
+    float *outputValues = factorMatrix.colptr(j);
+    for (unsigned int i = 0;i <= j;++i)
+    {
+      // Sum over k >= j of X(i, k) X(j, k), where X(j, j) is kept aside
+      const float *otherValues = factorMatrix.colptr(i);
+      double workValue = (i == j) ? diagonalValues[j] * diagonalValues[j] : (double)otherValues[j] * diagonalValues[j];
+      workValue += GetSinglePrecisionDotProduct(otherValues + j + 1, columnValues + j + 1, n - j - 1);
+      outputValues[i] = (float)workValue;
+    }
+  }
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) num_threads(numThreads)
+#endif
+  for (unsigned int i = 0;i < n;++i)
+  {
+    float *outputValues = factorMatrix.colptr(i);
+    for (unsigned int j = i + 1;j < n;++j)
+      outputValues[j] = factorMatrix(i, j);
+  }
 }
 
-double BaseLogLikelihood::GetIntegral()
+static void SolveUpperTriangular(const arma::fmat &factorMatrix, double *values)
 {
-  typedef boost::math::quadrature::gauss_kronrod<double, 61> QuadratureType;
-  const double lBound = 0.0;
-  const double uBound = std::numeric_limits<double>::infinity();
-
-  BaseIntegrand integrand;
-  integrand.SetKFunction(this->GetKFunction());
-  integrand.SetFirstAlpha(m_FirstAlpha);
-  integrand.SetSecondAlpha(m_SecondAlpha);
-  integrand.SetInverseCrossAlpha(m_InverseCrossAlpha);
-  integrand.SetFirstAmplitude(m_FirstAmplitude);
-  integrand.SetSecondAmplitude(m_SecondAmplitude);
-  integrand.SetCrossAmplitude(m_CrossAmplitude);
-  integrand.SetDomainDimension(m_DomainDimension);
-  auto GetIntegrandValue =              [&integrand](const double &t){return integrand(t);};
-  auto GetDerivativeWRTFirstAlpha =     [&integrand](const double &t){return integrand.GetDerivativeWRTFirstAlpha(t);};
-  auto GetDerivativeWRTCrossAlpha =     [&integrand](const double &t){return integrand.GetDerivativeWRTCrossAlpha(t);};
-  auto GetDerivativeWRTSecondAlpha =    [&integrand](const double &t){return integrand.GetDerivativeWRTSecondAlpha(t);};
-  auto GetDerivativeWRTCrossIntensity = [&integrand](const double &t){return integrand.GetDerivativeWRTCrossIntensity(t);};
-
-  double resVal = 2.0 * M_PI * QuadratureType::integrate(GetIntegrandValue, lBound, uBound);
-
-  m_GradientIntegral.set_size(this->GetNumberOfParameters());
-  m_GradientIntegral[0] = 2.0 * M_PI * QuadratureType::integrate(GetDerivativeWRTFirstAlpha,     lBound, uBound);
-  m_GradientIntegral[1] = 2.0 * M_PI * QuadratureType::integrate(GetDerivativeWRTCrossAlpha,     lBound, uBound);
-  m_GradientIntegral[2] = 2.0 * M_PI * QuadratureType::integrate(GetDerivativeWRTSecondAlpha,    lBound, uBound);
-  m_GradientIntegral[3] = 2.0 * M_PI * QuadratureType::integrate(GetDerivativeWRTCrossIntensity, lBound, uBound);
+  // R x = b in place by columns of R, accumulated in double precision
+  for (unsigned int i = factorMatrix.n_rows;i-- > 0;)
+  {
+    const float *columnValues = factorMatrix.colptr(i);
+    values[i] /= (double)columnValues[i];
+    for (unsigned int k = 0;k < i;++k)
+      values[k] -= (double)columnValues[k] * values[i];
+  }
+}
 
-  return resVal;
+static void SolveTransposedUpperTriangular(const arma::fmat &factorMatrix, double *values)
+{
+  // R^T x = b in place by columns of R, accumulated in double precision
+  for (unsigned int i = 0;i < factorMatrix.n_rows;++i)
+  {
+    const float *columnValues = factorMatrix.colptr(i);
+    double workValue = values[i];
+    for (unsigned int k = 0;k < i;++k)
+      workValue -= (double)columnValues[k] * values[k];
+    values[i] = workValue / (double)columnValues[i];
+  }
 }
 
-double BaseLogLikelihood::GetLogDeterminant()
+bool BaseLogLikelihood::GetSinglePrecisionLogDeterminant(const bool computeGradient, double &logDeterminant)
 {
-  arma::mat lMatrix(m_SampleSize, m_SampleSize);
-  arma::mat lMatrixDeriv1(m_SampleSize, m_SampleSize);
-  arma::mat lMatrixDeriv2(m_SampleSize, m_SampleSize);
-  arma::mat lMatrixDeriv3(m_SampleSize, m_SampleSize);
-  arma::mat lMatrixDeriv4(m_SampleSize, m_SampleSize);
-  double resVal = 0.0;
-  double workValue1 = 0.0;
-  double workValue2 = 0.0;
-  double workValue3 = 0.0;
-  double workValue4 = 0.0;
-  double workSign = 0.0;
+  arma::fmat factorMatrix;
+  this->BuildLMatrix(factorMatrix);
+  if (!FactorizeSinglePrecision(factorMatrix, m_NumberOfThreads))
+    return false;
 
+  double resVal = 0.0;
   for (unsigned int i = 0;i < m_SampleSize;++i)
+    resVal += std::log((double)factorMatrix(i, i));
+  resVal *= 2.0;
+
+  // The rounding errors of the entries and of the factorization are gathered
+  // in A = inv(R^T) L inv(R) - I, so that log det(L) = log det(R^T R) +
+  // log det(I + A) with log det(I + A) ~ trace(A) - trace(A^2) / 2. Both
+  // traces are estimated from Rademacher probes v as v^T A v and |A v|^2,
+  // where A v only involves solves with R and products with the exact L.
+  // For the eigenvalues x of A, |log(1 + x) - x + x^2 / 2| is at most
+  // |x|^3 / (3 (1 - |x|)), so that the truncation error is bounded by
+  // |A|_F^3 / (3 (1 - |A|_F)), the series diverging if |A|_F >= 1. Since
+  // |A|_F is itself estimated from the probes, so is this bound.
+  unsigned int numProbes = m_NumberOfCorrectionProbes;
+  arma::mat probeValues(m_SampleSize, numProbes);
+  for (unsigned int p = 0;p < numProbes;++p)
+  {
+    PhiloxGenerator generator(m_ProbeSeed, p);
+    for (unsigned int i = 0;i < m_SampleSize;++i)
+      probeValues(i, p) = (generator.GetUniform() < 0.5) ? -1.0 : 1.0;
+  }
+
+  arma::mat solutionValues = probeValues;
+
+  ParallelErrorHandler errorHandler;
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) num_threads(m_NumberOfThreads)
+#endif
+  for (unsigned int p = 0;p < numProbes;++p)
   {
-    for (unsigned int j = i;j < m_SampleSize;++j)
+    try
+    {
+      SolveUpperTriangular(factorMatrix, solutionValues.colptr(p));
+    }
+    catch (std::exception &e)
     {
-      double sqDist = m_DistanceMatrix(i, j) * m_DistanceMatrix(i, j);
-      unsigned int workLabel = m_PointLabels[i] + m_PointLabels[j];
-      double tmpVal = this->EvaluateL12Function(sqDist, m_FirstAmplitude, m_SecondAmplitude, m_CrossAmplitude, m_InverseCrossAlpha, m_DomainDimension);
+      errorHandler.Store(p, e);
+    }
+  }
+
+  errorHandler.Rethrow();
 
-      if (workLabel == 2)
-        resVal = this->EvaluateLFunction(sqDist, m_FirstAmplitude, m_CrossAmplitude, m_FirstAlpha, tmpVal, m_DomainDimension);
-      else if (workLabel == 3)
-        resVal = tmpVal;
-      else
-        resVal = this->EvaluateLFunction(sqDist, m_SecondAmplitude, m_CrossAmplitude, m_SecondAlpha, tmpVal, m_DomainDimension);
+  arma::mat productValues;
+  this->MultiplyDenseLMatrix(solutionValues.t(), productValues);
+  arma::mat residualValues = productValues.t();
+  arma::vec probeEstimates(numProbes), squaredNormEstimates(numProbes);
 
-      lMatrix(i, j) = resVal;
-      lMatrixDeriv1(i, j) = workValue1;
-      lMatrixDeriv2(i, j) = workValue2;
-      lMatrixDeriv3(i, j) = workValue3;
-      lMatrixDeriv4(i, j) = workValue4;
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) num_threads(m_NumberOfThreads)
+#endif
+  for (unsigned int p = 0;p < numProbes;++p)
+  {
+    try
+    {
+      double *residuals = residualValues.colptr(p);
+      const double *probes = probeValues.colptr(p);
+      SolveTransposedUpperTriangular(factorMatrix, residuals);
 
-      if (i != j)
+      double firstOrderValue = 0.0;
+      double secondOrderValue = 0.0;
+      for (unsigned int i = 0;i < m_SampleSize;++i)
       {
-        lMatrix(j, i) = resVal;
-        lMatrixDeriv1(j, i) = workValue1;
-        lMatrixDeriv2(j, i) = workValue2;
-        lMatrixDeriv3(j, i) = workValue3;
-        lMatrixDeriv4(j, i) = workValue4;
+        double workValue = residuals[i] - probes[i];
+        firstOrderValue += probes[i] * workValue;
+        secondOrderValue += workValue * workValue;
       }
+
+      probeEstimates[p] = firstOrderValue - 0.5 * secondOrderValue;
+      squaredNormEstimates[p] = secondOrderValue;
+    }
+    catch (std::exception &e)
+    {
+      errorHandler.Store(p, e);
     }
   }
 
-  arma::log_det(resVal, workSign, lMatrix);
-  arma::mat lMatrixInverse = arma::inv(lMatrix);
+  errorHandler.Rethrow();
+
+  double correctionValue = arma::mean(probeEstimates);
+  double normValue = std::sqrt(arma::mean(squaredNormEstimates));
+  if (!std::isfinite(correctionValue) || !(normValue < 1.0))
+    return false;
+
+  logDeterminant = resVal + correctionValue;
+  m_LogDeterminantError = normValue * normValue * normValue / (3.0 * (1.0 - normValue));
+  if (numProbes > 1)
+    m_LogDeterminantError += arma::stddev(probeEstimates) / std::sqrt((double)numProbes);
+
+  m_GradientLogDeterminant.set_size(6);
+  m_GradientLogDeterminant.fill(0.0);
+
+  if (!computeGradient)
+    return true;
+
+  // inv(L) ~ inv(R) inv(R)^T, left uncorrected: the gradient is that of
+  // log det(R^T R), the error of the inverse being of the order of |A|_F
+  // relative to inv(L)
+  InvertSinglePrecisionFactor(factorMatrix, m_NumberOfThreads);
+  this->AccumulateGradientLogDeterminant(factorMatrix);
+
+  return true;
+}
+
+void BaseLogLikelihood::PrepareLFunctions()
+{
+  this->UpdateLFunctions();
+  if (!this->AreLFunctionsCapped())
+    return;
+
+  ++m_NumberOfCappedLFunctions;
+  m_Profiler.Increment(EvaluationProfiler::CappedLFunctionCounter);
+}
+
+void BaseLogLikelihood::WarnCappedLFunctions()
+{
+  if (m_NumberOfCappedLFunctions == 0 || m_CappedLFunctionsWarned)
+    return;
+
+  m_CappedLFunctionsWarned = true;
+  Rcpp::warning(
+    "the entries of the L-matrix were tabulated with a capped grid or "
+    "quadrature, which degrades their accuracy, as the spatial scales of the "
+    "kernels differ by orders of magnitude");
+}
+
+double BaseLogLikelihood::GetLogDeterminant(const bool computeGradient)
+{
+  m_ValidLogDeterminant = true;
+  m_LogDeterminantError = 0.0;
+
+  m_Profiler.Start(EvaluationProfiler::AssemblyPhase);
+  this->PrepareLFunctions();
+  m_Profiler.Stop(EvaluationProfiler::AssemblyPhase);
+
+  if (m_NumberOfProbes > 0)
+    return this->GetStochasticLogDeterminant(computeGradient);
+
+  if (m_UseSparseLMatrix)
+    return this->GetSparseLogDeterminant(computeGradient);
+
+  double resVal = 0.0;
+  if (m_UseSinglePrecision && this->GetSinglePrecisionLogDeterminant(computeGradient, resVal))
+    return resVal;
+
+  // The L-matrix is symmetric positive definite for valid parameters so its
+  // Cholesky factor R (L = R^T R) is computed in place. Its diagonal gives the
+  // log-determinant and, if needed, it also provides the inverse of L.
+  arma::mat lMatrix;
+  this->BuildLMatrix(lMatrix);
+  bool validFactorization = arma::chol(lMatrix, lMatrix);
+
+  if (validFactorization)
+  {
+    for (unsigned int i = 0;i < m_SampleSize;++i)
+      resVal += std::log(lMatrix(i, i));
+    resVal *= 2.0;
+  }
+  else
+  {
+    // Not a valid DPP kernel: fall back to the log of the absolute value of
+    // the determinant.
+    double workSign = 0.0;
+    this->BuildLMatrix(lMatrix);
+    arma::log_det(resVal, workSign, lMatrix);
+  }
+
+  m_GradientLogDeterminant.set_size(6);
+  m_GradientLogDeterminant.fill(0.0);
+
+  if (!computeGradient)
+    return resVal;
+
+  if (validFactorization)
+  {
+    arma::mat rInverse = arma::inv(arma::trimatu(lMatrix));
+    lMatrix = rInverse * rInverse.t();
+  }
+  else
+    lMatrix = arma::inv(lMatrix);
 
-  m_GradientLogDeterminant.set_size(this->GetNumberOfParameters());
-  m_GradientLogDeterminant[0] = arma::trace(lMatrixInverse * lMatrixDeriv1);
-  m_GradientLogDeterminant[1] = arma::trace(lMatrixInverse * lMatrixDeriv2);
-  m_GradientLogDeterminant[2] = arma::trace(lMatrixInverse * lMatrixDeriv3);
-  m_GradientLogDeterminant[3] = arma::trace(lMatrixInverse * lMatrixDeriv4);
+  this->AccumulateGradientLogDeterminant(lMatrix);
 
   return resVal;
 }
 
-double BaseLogLikelihood::Evaluate(const arma::mat& x)
+template <class TMatrix>
+void BaseLogLikelihood::AccumulateGradientLogDeterminant(const TMatrix &inverseMatrix)
 {
-  this->SetModelParameters(x);
+  // Both the inverse and the derivatives are symmetric so that
+  // trace(inv(L) * dL) is the sum over pairs of inv(L)_ij * dL_ij, counting
+  // off-diagonal pairs twice. The derivatives of a row are evaluated by
+  // spans of pairs sharing a kernel. Sums are accumulated per point and added
+  // up in a fixed order so that the result does not depend on the number of
+  // threads.
+  unsigned int n1 = m_FirstSampleSize;
+  unsigned int n2 = m_SecondSampleSize;
+  arma::mat workSums(6, m_SampleSize);
+  workSums.fill(0.0);
+
+  double firstDiagonal[6], secondDiagonal[6];
+  this->EvaluateLDerivatives(0.0, 0, firstDiagonal);
+  this->EvaluateLDerivatives(0.0, 2, secondDiagonal);
+
+  ParallelErrorHandler errorHandler;
+  ThreadWorkspace derivativeWorkspace(m_NumberOfThreads, 6 * (n1 + n2));
+  ThreadWorkspace workWorkspace(m_NumberOfThreads, 4 * (n1 + n2));
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(m_NumberOfThreads)
+#endif
+  for (unsigned int i = 0;i < n1;++i)
+  {
+    try
+    {
+      double *rowSums = workSums.colptr(i);
+      const typename TMatrix::elem_type *inverseValues = inverseMatrix.colptr(i);
+      double *derivatives = derivativeWorkspace.GetValues();
+      double *workValues = workWorkspace.GetValues();
+      unsigned int numValues = n1 - i - 1;
+      const double *sqDistances = m_FirstSquaredDistances.memptr() + this->GetPackedRowOffset(i, n1);
+      this->EvaluateLDerivativeEntries(sqDistances, numValues, 0, derivatives, workValues);
+
+      for (unsigned int k = 0;k < 6;++k)
+        rowSums[k] += inverseValues[i] * firstDiagonal[k];
+
+      for (unsigned int j = 0;j < numValues;++j)
+      {
+        const double *entryDerivatives = derivatives + 6 * j;
+        for (unsigned int k = 0;k < 6;++k)
+          rowSums[k] += 2.0 * inverseValues[i + 1 + j] * entryDerivatives[k];
+      }
 
-  if (m_Modified)
+      sqDistances = m_CrossSquaredDistances.memptr() + (arma::uword)i * n2;
+      this->EvaluateLDerivativeEntries(sqDistances, n2, 1, derivatives, workValues);
+
+      for (unsigned int j = 0;j < n2;++j)
+      {
+        const double *entryDerivatives = derivatives + 6 * j;
+        for (unsigned int k = 0;k < 6;++k)
+          rowSums[k] += 2.0 * inverseValues[n1 + j] * entryDerivatives[k];
+      }
+    }
+    catch (std::exception &e)
+    {
+      errorHandler.Store(i, e);
+    }
+  }
+
+  errorHandler.Rethrow();
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(m_NumberOfThreads)
+#endif
+  for (unsigned int i = 0;i < n2;++i)
+  {
+    try
+    {
+      double *rowSums = workSums.colptr(n1 + i);
+      const typename TMatrix::elem_type *inverseValues = inverseMatrix.colptr(n1 + i);
+      double *derivatives = derivativeWorkspace.GetValues();
+      double *workValues = workWorkspace.GetValues();
+      unsigned int numValues = n2 - i - 1;
+      const double *sqDistances = m_SecondSquaredDistances.memptr() + this->GetPackedRowOffset(i, n2);
+      this->EvaluateLDerivativeEntries(sqDistances, numValues, 2, derivatives, workValues);
+
+      for (unsigned int k = 0;k < 6;++k)
+        rowSums[k] += inverseValues[n1 + i] * secondDiagonal[k];
+
+      for (unsigned int j = 0;j < numValues;++j)
+      {
+        const double *entryDerivatives = derivatives + 6 * j;
+        for (unsigned int k = 0;k < 6;++k)
+          rowSums[k] += 2.0 * inverseValues[n1 + i + 1 + j] * entryDerivatives[k];
+      }
+    }
+    catch (std::exception &e)
+    {
+      errorHandler.Store(n1 + i, e);
+    }
+  }
+
+  errorHandler.Rethrow();
+
+  for (unsigned int i = 0;i < m_SampleSize;++i)
   {
+    for (unsigned int k = 0;k < 6;++k)
+      m_GradientLogDeterminant[k] += workSums(k, i);
+  }
+}
+
+template void BaseLogLikelihood::AccumulateGradientLogDeterminant<arma::mat>(const arma::mat &inverseMatrix);
+template void BaseLogLikelihood::AccumulateGradientLogDeterminant<arma::fmat>(const arma::fmat &inverseMatrix);
+
+void BaseLogLikelihood::CheckFiniteness(const arma::mat &x, const std::string &caller)
+{
+  // A standard exception rather than Rcpp::stop() so that the likelihood can
+  // also be evaluated from worker threads, where the R API is off limits.
+  if (std::isfinite(m_Integral) && std::isfinite(m_LogDeterminant))
+    return;
+
+  std::ostringstream message;
+  message << "Non finite value in " << caller << "(): integral = " << m_Integral;
+  message << ", log-determinant = " << m_LogDeterminant << ", parameters =";
+  for (unsigned int i = 0;i < x.n_elem;++i)
+    message << " " << x[i];
+
+  throw std::runtime_error(message.str());
+}
+
+void BaseLogLikelihood::UpdateValues(const bool computeGradient)
+{
+  arma::vec parameterKey = {m_FirstAmplitude, m_FirstAlpha, m_SecondAmplitude, m_SecondAlpha, m_CrossAmplitude, m_InverseCrossAlpha};
+  CachedValues *cachedValues = m_EvaluationCache.Find(parameterKey);
+  m_Profiler.Increment(EvaluationProfiler::EvaluationCounter);
+
+  if (cachedValues == NULL)
+  {
+    m_Profiler.Start(EvaluationProfiler::IntegralPhase);
     m_Integral = this->GetIntegral();
-    m_LogDeterminant = this->GetLogDeterminant();
+    m_Profiler.Stop(EvaluationProfiler::IntegralPhase);
+    m_Profiler.Increment(EvaluationProfiler::IntegralCounter);
+
+    m_Profiler.Start(EvaluationProfiler::LogDeterminantPhase);
+    m_LogDeterminant = this->GetLogDeterminant(computeGradient);
+    m_Profiler.Stop(EvaluationProfiler::LogDeterminantPhase);
+    m_Profiler.Increment(EvaluationProfiler::LogDeterminantCounter);
+
+    cachedValues = m_EvaluationCache.Insert(parameterKey);
+    if (cachedValues == NULL)
+      return;
+
+    cachedValues->m_Integral = m_Integral;
+    cachedValues->m_GradientIntegral = m_GradientIntegral;
   }
+  else
+  {
+    m_Integral = cachedValues->m_Integral;
+    m_GradientIntegral = cachedValues->m_GradientIntegral;
+
+    if (!computeGradient || cachedValues->m_HasGradient)
+    {
+      m_Profiler.Increment(EvaluationProfiler::CacheHitCounter);
+      m_LogDeterminant = cachedValues->m_LogDeterminant;
+      m_LogDeterminantError = cachedValues->m_LogDeterminantError;
+      m_GradientLogDeterminant = cachedValues->m_GradientLogDeterminant;
+      m_ValidLogDeterminant = cachedValues->m_ValidLogDeterminant;
+      return;
+    }
+
+    m_Profiler.Increment(EvaluationProfiler::PartialCacheHitCounter);
+    m_Profiler.Start(EvaluationProfiler::LogDeterminantPhase);
+    m_LogDeterminant = this->GetLogDeterminant(true);
+    m_Profiler.Stop(EvaluationProfiler::LogDeterminantPhase);
+    m_Profiler.Increment(EvaluationProfiler::LogDeterminantCounter);
+  }
+
+  cachedValues->m_LogDeterminant = m_LogDeterminant;
+  cachedValues->m_LogDeterminantError = m_LogDeterminantError;
+  cachedValues->m_GradientLogDeterminant = m_GradientLogDeterminant;
+  cachedValues->m_ValidLogDeterminant = m_ValidLogDeterminant;
+  cachedValues->m_HasGradient = computeGradient;
+}
 
-  if (!std::isfinite(m_Integral) || !std::isfinite(m_LogDeterminant))
+arma::vec BaseLogLikelihood::TimeEvaluation(const arma::mat &params, const unsigned int numRepeats)
+{
+  unsigned int numTimings = (numRepeats > 0) ? numRepeats : 1;
+  arma::vec timings(4);
+  timings.fill(0.0);
+
+  this->SetModelParameters(params);
+  arma::wall_clock clock;
+
+  for (unsigned int r = 0;r < numTimings;++r)
   {
-    Rcpp::Rcout << m_Integral << " " << m_LogDeterminant << " " << x.as_row() << std::endl;
-    Rcpp::stop("Non finite stuff in evaluate");
+    this->ClearCache();
+    clock.tic();
+    this->GetIntegral();
+    timings[0] += clock.toc();
+
+    this->ClearCache();
+    clock.tic();
+    this->GetLogDeterminant(false);
+    timings[1] += clock.toc();
+
+    this->ClearCache();
+    clock.tic();
+    this->GetLogDeterminant(true);
+    timings[2] += clock.toc();
+
+    // Last so that the stored values match the parameters
+    this->ClearCache();
+    clock.tic();
+    this->Evaluate(params);
+    timings[3] += clock.toc();
   }
 
+  timings /= (double)numTimings;
+
+  return timings;
+}
+
+arma::mat BaseLogLikelihood::GetLEntries(const arma::mat &params, const arma::vec &distances, arma::vec &naturalParameters)
+{
+  this->SetModelParameters(params);
+  this->PrepareLFunctions();
+  naturalParameters = {m_FirstAmplitude, m_FirstAlpha, m_SecondAmplitude, m_SecondAlpha, m_CrossAmplitude, m_InverseCrossAlpha};
+
+  arma::vec sqDistances = distances % distances;
+  arma::mat lEntries(sqDistances.n_elem, 3);
+  arma::vec workValues(sqDistances.n_elem);
+  for (unsigned int labelPair = 0;labelPair < 3;++labelPair)
+    this->EvaluateLEntries(sqDistances.memptr(), sqDistances.n_elem, labelPair, lEntries.colptr(labelPair), workValues.memptr());
+
+  return lEntries;
+}
+
+double BaseLogLikelihood::Evaluate(const arma::mat& x)
+{
+  this->SetModelParameters(x);
+
+  this->UpdateValues(false);
+
+  if (!m_ValidLogDeterminant)
+    return DBL_MAX;
+
+  this->CheckFiniteness(x, "Evaluate");
+
   double logLik = 2.0 * m_DomainVolume;
   logLik += m_DomainVolume * m_Integral;
   logLik += m_LogDeterminant;
@@ -244,20 +1668,26 @@ void BaseLogLikelihood::Gradient(const arma::mat& x, arma::mat &g)
     return;
   }
 
-  if (m_Modified)
-  {
-    m_Integral = this->GetIntegral();
-    m_LogDeterminant = this->GetLogDeterminant();
-  }
+  this->UpdateValues(true);
 
-  if (!std::isfinite(m_Integral) || !std::isfinite(m_LogDeterminant))
+  if (!m_ValidLogDeterminant)
   {
-    Rcpp::Rcout << m_Integral << " " << m_LogDeterminant << " " << x.as_row() << std::endl;
-    Rcpp::stop("Non finite stuff in gradient");
+    g.fill(0.0);
+    return;
   }
 
+  this->CheckFiniteness(x, "Gradient");
+
+  // Chain rule from the natural parameters to the optimizer ones
+  arma::mat jacobian;
+  this->GetParameterJacobian(jacobian);
+
   for (unsigned int i = 0;i < this->GetNumberOfParameters();++i)
-    g[i] = m_DomainVolume * m_GradientIntegral[i] + m_GradientLogDeterminant[i];
+  {
+    g[i] = 0.0;
+    for (unsigned int k = 0;k < jacobian.n_rows;++k)
+      g[i] += jacobian(k, i) * (m_DomainVolume * m_GradientIntegral[k] + m_GradientLogDeterminant[k]);
+  }
 
   g *= -2.0;
 }
@@ -274,21 +1704,30 @@ double BaseLogLikelihood::EvaluateWithGradient(const arma::mat& x, arma::mat& g)
     return DBL_MAX;
   }
 
-  m_Integral = this->GetIntegral();
-  m_LogDeterminant = this->GetLogDeterminant();
+  this->UpdateValues(true);
 
-  if (!std::isfinite(m_Integral) || !std::isfinite(m_LogDeterminant))
+  if (!m_ValidLogDeterminant)
   {
-    Rcpp::Rcout << m_Integral << " " << m_LogDeterminant << " " << x.as_row() << std::endl;
-    Rcpp::stop("Non finite stuff in evaluate with gradient");
+    g.fill(0.0);
+    return DBL_MAX;
   }
 
+  this->CheckFiniteness(x, "EvaluateWithGradient");
+
   double logLik = 2.0 * m_DomainVolume;
   logLik += m_DomainVolume * m_Integral;
   logLik += m_LogDeterminant;
 
+  // Chain rule from the natural parameters to the optimizer ones
+  arma::mat jacobian;
+  this->GetParameterJacobian(jacobian);
+
   for (unsigned int i = 0;i < this->GetNumberOfParameters();++i)
-    g[i] = m_DomainVolume * m_GradientIntegral[i] + m_GradientLogDeterminant[i];
+  {
+    g[i] = 0.0;
+    for (unsigned int k = 0;k < jacobian.n_rows;++k)
+      g[i] += jacobian(k, i) * (m_DomainVolume * m_GradientIntegral[k] + m_GradientLogDeterminant[k]);
+  }
 
   g *= -2.0;
 
@@ -380,9 +1819,9 @@ void BaseLogLikelihood::SetModelParameters(const arma::mat &params)
   // Set alpha_i_star
   if (m_EstimateIntensities)
   {
-    double gammaValue = boost::math::tgamma(1.0 + (double)m_DomainDimension / 2.0);
-    double upperBound = std::pow(m_DomainVolume / gammaValue, 1.0 / (double)m_DomainDimension);
-    upperBound /= std::sqrt(2.0 * M_PI / (double)m_DomainDimension);
+    // Largest alpha compatible with at least one point in the domain
+    double upperBound = this->RetrieveAlphaFromParameters(1.0, 1.0 / m_DomainVolume, m_DomainDimension);
+    m_AlphaUpperBound = upperBound;
 
     workScalar = params[pos];
 
@@ -428,22 +1867,30 @@ bool BaseLogLikelihood::CheckModelParameters()
   return true;
 }
 
-double BaseLogLikelihood::GetBesselJRatio(const double sqDist, const double alpha, const unsigned int dimension, const bool cross)
+double BaseLogLikelihood::GetBesselJRatio(const double sqDist, const double alpha, const bool cross)
 {
   // if cross is true, alpha is in fact its inverse
-  double order = (double)dimension / 2.0;
+  double order = (double)m_DomainDimension / 2.0;
   double tmpVal = (cross) ? alpha : 1.0 / alpha;
-  tmpVal *= std::sqrt(2.0 * (double)dimension * sqDist);
+  tmpVal *= std::sqrt(2.0 * (double)m_DomainDimension * sqDist);
+
+  if (m_BesselJRatioTable.IsBuilt())
+    return m_BesselJRatioTable.Evaluate(tmpVal);
 
-  if (tmpVal < std::sqrt(std::numeric_limits<double>::epsilon()))
-    return 1.0 / boost::math::tgamma(1.0 + order);
+  return BesselJRatioTable::GetExactValue(tmpVal, order);
+}
+
+double BaseLogLikelihood::GetBesselJRatioDerivative(const double sqDist, const double alpha, const bool cross)
+{
+  // Derivative w.r.t. alpha, or w.r.t. its inverse if cross is true, through
+  // the argument x which is proportional to 1 / alpha
+  double order = (double)m_DomainDimension / 2.0;
+  double tmpVal = (cross) ? alpha : 1.0 / alpha;
+  tmpVal *= std::sqrt(2.0 * (double)m_DomainDimension * sqDist);
+  double derivArgument = (cross) ? tmpVal / alpha : -tmpVal / alpha;
 
-  // if (tmpVal > 1.0e5)
-  // {
-  //   double resVal = (cross) ? std::cos(tmpVal - M_PI / (2.0 * alpha) - M_PI / 4.0) : std::cos(tmpVal - alpha * M_PI / 2.0 - M_PI / 4.0);
-  //   resVal *= (std::pow(2.0, order) * std::sqrt(2.0 / M_PI)  / std::pow(tmpVal, 0.5 + order));
-  //   return resVal;
-  // }
+  if (m_BesselJRatioTable.IsBuilt())
+    return m_BesselJRatioTable.EvaluateDerivative(tmpVal) * derivArgument;
 
-  return boost::math::cyl_bessel_j(order, tmpVal) / std::pow(tmpVal / 2.0, order);
+  return BesselJRatioTable::GetExactDerivative(tmpVal, order) * derivArgument;
 }
@@ -1,12 +1,19 @@
+#pragma once
+
 #include "integrandFunctions.h"
+#include "besselJRatioTable.h"
+#include "dimensionTraits.h"
+#include "envelopeCholesky.h"
+#include "stochasticLogDeterminant.h"
+#include "parameterCache.h"
+#include "evaluationProfiler.h"
+#include "parallelErrorHandler.h"
+#include "threadWorkspace.h"
 #include <RcppEnsmallen.h>
 
 class BaseLogLikelihood
 {
 public:
-  typedef std::vector  <std::vector <int> > NeighborhoodType;
-  typedef BaseIntegrand::KFunctionType KFunctionType;
-
   BaseLogLikelihood()
   {
     m_FirstAmplitude = NA_REAL;
@@ -19,13 +26,30 @@ public:
 
     m_DomainDimension = 1;
     m_DomainVolume = 1.0;
+    m_MaximalDistance = 0.0;
     m_UsePeriodicDomain = true;
     m_Modified = true;
     m_Integral = 0.0;
     m_LogDeterminant = 0.0;
+    m_BesselJRatioTolerance = 0.0;
+    m_NumberOfThreads = 1;
+    m_AlphaUpperBound = 1.0;
+    m_SparseTolerance = 0.0;
+    m_CutoffRadius = 0.0;
+    m_NeighbourRadius = 0.0;
+    m_UseSparseLMatrix = false;
+    m_MaximalNumberOfNeighbours = 0;
+    m_ValidLogDeterminant = true;
+    m_NumberOfProbes = 0;
+    m_ProbeSeed = 0;
+    m_UseSinglePrecision = false;
+    m_NumberOfCorrectionProbes = 16;
+    m_LogDeterminantError = 0.0;
+    m_NumberOfCappedLFunctions = 0;
+    m_CappedLFunctionsWarned = false;
   }
 
-  ~BaseLogLikelihood() {}
+  virtual ~BaseLogLikelihood() {}
 
   void SetInputs(
       const arma::mat &points,
@@ -34,6 +58,103 @@ public:
       const arma::vec &ub
   );
   void SetUsePeriodicDomain(const bool x) {m_UsePeriodicDomain = x;}
+  unsigned int GetNumberOfParameters();
+
+  //! Box constraints on the optimizer parameters (k1, k2, k12star, beta12,
+  //! [alpha1star, alpha2star])
+  void GetParameterBounds(arma::vec &lowerBounds, arma::vec &upperBounds);
+
+  //! Use a lookup table with the given absolute accuracy instead of boost for
+  //! evaluating the Bessel J ratio. A non-positive tolerance disables it.
+  void SetBesselJRatioTolerance(const double x);
+
+  //! Number of OpenMP threads used for building the distance matrix and the
+  //! L-matrix. Results do not depend on it.
+  void SetNumberOfThreads(const unsigned int n) {m_NumberOfThreads = (n > 0) ? n : 1;}
+
+  //! Keep only the entries of the L-matrix for pairs of points closer than a
+  //! cutoff radius and compute its log-determinant by a sparse Cholesky
+  //! factorization. The pairs are found by a cell list in SetInputs(), which
+  //! must thus be called afterwards. By default, the radius is the one beyond
+  //! which the marginal kernel at the largest alpha allowed by the observed
+  //! intensities stays below the given fraction of its value at the origin.
+  //! A non-positive tolerance disables it.
+  void SetSparseTolerance(const double x) {m_SparseTolerance = (arma::is_finite(x)) ? x : 0.0;}
+
+  //! Overrides the cutoff radius derived from the sparse tolerance if positive
+  void SetCutoffRadius(const double x) {m_CutoffRadius = (arma::is_finite(x)) ? x : 0.0;}
+
+  //! Cutoff radius used by the sparse L-matrix, or 0 if it is dense
+  double GetCutoffRadius() const {return m_NeighbourRadius;}
+
+  //! Estimate the log-determinant of the L-matrix and its gradient by
+  //! stochastic Lanczos quadrature with the given number of probes instead of
+  //! a Cholesky factorization. Only products with the L-matrix are needed,
+  //! which only involve the pairs within the cutoff radius if the sparse
+  //! L-matrix is enabled, and whose entries are otherwise computed on the fly
+  //! without storing the dense L-matrix. Each probe runs a fixed number of
+  //! steps, so that the estimate is smooth in the parameters. The gradient is
+  //! a Hutchinson estimate from the approximate solutions of the same steps,
+  //! not the derivative of the estimate. Must be called before SetInputs().
+  //! Zero (default) gives the exact log-determinant.
+  void SetNumberOfProbes(const unsigned int n);
+
+  //! Seed of the probes, shared by all evaluations
+  void SetProbeSeed(const uint64_t x);
+
+  //! Assembles and factorizes the dense L-matrix in single precision, which
+  //! halves its memory footprint. The factorization does not rely on LAPACK
+  //! and is slower than the double precision one, so that this only saves
+  //! memory. The log-determinant is then corrected in double precision by a
+  //! stochastic estimate of log det(I + A) truncated at second order, with A
+  //! the residual of the factorization relative to the exact L-matrix. Its
+  //! error is estimated by the standard error of the correction over the
+  //! probes plus the truncation bound evaluated at the Frobenius norm of A
+  //! estimated from the same probes, which is thus not a bound either. The gradient is approximate since it
+  //! comes from the uncorrected single precision inverse. Falls back to double
+  //! precision if the factorization fails or if |A|_F >= 1.
+  void SetSinglePrecision(const bool x);
+
+  //! Number of probes of the single precision correction (16 by default)
+  void SetNumberOfCorrectionProbes(const unsigned int n);
+
+  //! Error of the last stochastic log-determinant, i.e. its standard error
+  //! over the probes, or of the last single precision correction, i.e. its
+  //! standard error plus an estimate of its truncation error, or 0 if exact.
+  //! Both estimate the error but do not bound it.
+  double GetLogDeterminantError() const {return m_LogDeterminantError;}
+
+  //! Number of parameter vectors whose integral, log-determinant and
+  //! gradients are kept for later calls (16 by default). Zero disables the
+  //! cache.
+  void SetCacheSize(const unsigned int n) {m_EvaluationCache.SetMaximalSize(n);}
+
+  //! Mean wall-clock times in seconds of the integral, the log-determinant
+  //! without and with its gradient and a full evaluation at the given
+  //! optimizer parameters. Cached values are discarded before each timing so
+  //! that every phase is computed from scratch.
+  arma::vec TimeEvaluation(const arma::mat &params, const unsigned int numRepeats = 1);
+
+  //! Entries of the L-matrix at the given optimizer parameters for pairs of
+  //! points at the given distances, with the label pairs 1-1, 1-2 and 2-2 in
+  //! columns, along with the natural parameters (k1, alpha1, k2, alpha2, k12,
+  //! 1 / alpha12) they were computed for. Entries of models without closed
+  //! form are only tabulated up to the largest distance between two points.
+  arma::mat GetLEntries(const arma::mat &params, const arma::vec &distances, arma::vec &naturalParameters);
+
+  //! Counters and timers of the evaluations, reset when enabled. Enable them
+  //! before SetInputs() to also time the preparation of the inputs.
+  void SetProfiling(const bool x);
+  Rcpp::List GetProfile() const {return m_Profiler.GetReport();}
+
+  //! Number of evaluations whose L functions hit the size caps of their
+  //! table, which degrades their accuracy, e.g. when the spatial scales of
+  //! the kernels differ by several orders of magnitude
+  unsigned int GetNumberOfCappedLFunctions() const {return m_NumberOfCappedLFunctions;}
+
+  //! Raises an R warning the first time the L functions hit the caps, to be
+  //! called by the exported functions once the evaluation is over
+  void WarnCappedLFunctions();
   arma::mat GetInitialPoint();
   virtual double RetrieveIntensityFromParameters(
       const double amplitude,
@@ -87,56 +208,282 @@ public:
 
 protected:
   //! Generic functions to be implemented in each child class
-  virtual double EvaluateLFunction(
+  //! Spatial kernel whose Fourier transform is GetFourierKernel(), i.e. the
+  //! kernel for a unit amplitude, in the dimension of the domain. If cross is
+  //! true, alpha is in fact its inverse.
+  virtual double EvaluateSpatialKernel(
       const double sqDist,
-      const double amplitude,
-      const double amplitude12,
       const double alpha,
-      const double l12Value,
-      const unsigned int dimension) = 0;
-  virtual double EvaluateL12Function(
+      const bool cross = false) = 0;
+  //! Derivative of EvaluateSpatialKernel() w.r.t. alpha, or w.r.t. its
+  //! inverse if cross is true
+  virtual double EvaluateSpatialKernelDerivative(
       const double sqDist,
-      const double amplitude1,
-      const double amplitude2,
-      const double amplitude12,
-      const double alpha12inv,
-      const unsigned int dimension) = 0;
+      const double alpha,
+      const bool cross = false) = 0;
+  //! EvaluateSpatialKernel() over a contiguous span of n squared distances
+  virtual void EvaluateSpatialKernels(
+      const double *sqDistances,
+      const unsigned int n,
+      const double alpha,
+      const bool cross,
+      double *values) = 0;
+  //! EvaluateSpatialKernelDerivative() over a contiguous span of n squared
+  //! distances
+  virtual void EvaluateSpatialKernelDerivatives(
+      const double *sqDistances,
+      const unsigned int n,
+      const double alpha,
+      const bool cross,
+      double *values) = 0;
   virtual double GetCrossAlphaLowerBound() = 0;
-  virtual KFunctionType GetKFunction() = 0;
+  virtual void GetCrossAlphaLowerBoundDerivatives(double &firstDerivative, double &secondDerivative) = 0;
+
+  //! Hook for precomputing kernel quantities which depend on the inputs, such
+  //! as the kernels specialized on the domain dimension, called by
+  //! SetInputs() before any kernel evaluation
+  virtual void InitializeKernel() {}
+
+  //! Discards the cached evaluations and the L functions, to be called
+  //! whenever the kernels change for given model parameters
+  void ClearCache();
+
+  //! Spectral integral by quadrature, to be implemented in each child class
+  //! by calling IntegrateFourierKernel() with its own type so that the Fourier
+  //! kernel is resolved at compile time. Same output as GetAnalyticIntegral().
+  virtual void IntegrateSpectralDensity(double &value, arma::vec &gradient) = 0;
+
+  //! Optional closed-form spectral integral. Models whose Fourier kernels
+  //! allow it return true and store the integral in value along with its
+  //! partial derivatives w.r.t. (k1, alpha1, k2, alpha2, k12, 1 / alpha12) in
+  //! gradient. Otherwise, the integral is computed by quadrature.
+  virtual bool GetAnalyticIntegral(double &value, arma::vec &gradient) {return false;}
   double GetBesselJRatio(
       const double sqDist,
       const double alpha,
-      const unsigned int dimension,
       const bool cross = false
   );
+  double GetBesselJRatioDerivative(
+      const double sqDist,
+      const double alpha,
+      const bool cross = false
+  );
+
+  //! Same as above with the constants of the dimension known at compile time
+  template <unsigned int TDimension>
+  double GetBesselJRatio(const double sqDist, const double alpha, const bool cross = false);
+  template <unsigned int TDimension>
+  double GetBesselJRatioDerivative(const double sqDist, const double alpha, const bool cross = false);
   double GetFirstAlpha() {return m_FirstAlpha;}
   double GetSecondAlpha() {return m_SecondAlpha;}
+  double GetInverseCrossAlpha() {return m_InverseCrossAlpha;}
+  double GetFirstAmplitude() {return m_FirstAmplitude;}
+  double GetSecondAmplitude() {return m_SecondAmplitude;}
+  double GetCrossAmplitude() {return m_CrossAmplitude;}
+  unsigned int GetDomainDimension() {return m_DomainDimension;}
+
+  //! Volume pi^(d / 2) / Gamma(1 + d / 2) of the unit ball of the domain, so
+  //! that the sphere of radius t has area d times this volume times t^(d - 1)
+  double GetUnitBallVolume();
+
+  template <class TModel>
+  void IntegrateFourierKernel(double &value, arma::vec &gradient)
+  {
+    typedef FusedIntegrand<TModel> IntegrandType;
+    IntegrandType integrand;
+    integrand.SetModel(static_cast<const TModel *>(this));
+    integrand.SetFirstAlpha(m_FirstAlpha);
+    integrand.SetSecondAlpha(m_SecondAlpha);
+    integrand.SetInverseCrossAlpha(m_InverseCrossAlpha);
+    integrand.SetFirstAmplitude(m_FirstAmplitude);
+    integrand.SetSecondAmplitude(m_SecondAmplitude);
+    integrand.SetCrossAmplitude(m_CrossAmplitude);
+    integrand.SetDomainDimension(m_DomainDimension);
+
+    typename IntegrandType::ValueType workValues;
+    unsigned int numNodes = FusedQuadrature<IntegrandType>::Integrate(integrand, workValues);
+    m_Profiler.Increment(EvaluationProfiler::QuadratureNodeCounter, numNodes);
+
+    // Radial integral times the area of the unit sphere
+    double sphereArea = (double)m_DomainDimension * this->GetUnitBallVolume();
+    value = sphereArea * workValues[0];
+    gradient.set_size(IntegrandType::NumberOfComponents - 1);
+    for (unsigned int i = 1;i < IntegrandType::NumberOfComponents;++i)
+      gradient[i - 1] = sphereArea * workValues[i];
+  }
+
+  //! Entries of the L-matrix L = K (I - K)^-1 for a span of n squared
+  //! distances between points of labels 1-1 (labelPair = 0), 1-2 (1) or 2-2
+  //! (2) at the current natural parameters, with a work array of the same
+  //! length, to be implemented in each child class from its kernels
+  virtual void EvaluateLEntries(
+      const double *sqDistances,
+      const unsigned int n,
+      const unsigned int labelPair,
+      double *values,
+      double *workValues) = 0;
+
+  //! Partial derivatives of EvaluateLEntries() w.r.t. the natural
+  //! parameters (k1, alpha1, k2, alpha2, k12, 1 / alpha12), the six
+  //! derivatives of each entry being contiguous, with a work array of 4 n
+  //! values
+  virtual void EvaluateLDerivativeEntries(
+      const double *sqDistances,
+      const unsigned int n,
+      const unsigned int labelPair,
+      double *derivatives,
+      double *workValues) = 0;
+
+  //! Hook called before the entries of the L-matrix are evaluated for new
+  //! natural parameters, e.g. to tabulate them
+  virtual void UpdateLFunctions() {}
+
+  //! Hook called by ClearCache() to discard what UpdateLFunctions() computed
+  virtual void ClearLFunctions() {}
+
+  //! Whether what UpdateLFunctions() computed was coarsened by size caps
+  virtual bool AreLFunctionsCapped() const {return false;}
+
+  //! Largest distance between two points whose entry of the L-matrix is
+  //! stored
+  double GetMaximalDistance() {return m_MaximalDistance;}
+  unsigned int GetNumberOfThreads() {return m_NumberOfThreads;}
 
 private:
-  //! Helper functions for periodizing the domain
-  unsigned int GetNumberOfParameters();
-  void SetNeighborhood(const unsigned int n);
-  std::vector<arma::rowvec> GetTrialVectors(
-      const arma::rowvec &x,
+  arma::uword GetPackedRowOffset(const arma::uword i, const arma::uword n);
+  void ComputeSquaredDistances(
+      const arma::mat &points,
       const arma::vec &lb,
-      const arma::vec &ub
+      const arma::vec &ub,
+      const unsigned int index,
+      const unsigned int firstIndex,
+      const unsigned int lastIndex,
+      double *sqDistances
   );
   void SetModelParameters(const arma::mat &params);
   bool CheckModelParameters();
+  void CheckFiniteness(const arma::mat &x, const std::string &caller);
   double GetIntegral();
-  double GetLogDeterminant();
+
+  //! Dense L-matrix, in double (arma::mat) or single (arma::fmat) precision
+  template <class TMatrix>
+  void BuildLMatrix(TMatrix &lMatrix);
+
+  //! Partial derivatives of EvaluateLEntry() w.r.t. the natural parameters
+  void EvaluateLDerivatives(const double sqDist, const unsigned int labelPair, double *derivatives);
+  void GetParameterJacobian(arma::mat &jacobian);
+  double GetLogDeterminant(const bool computeGradient);
+
+  //! Calls UpdateLFunctions() and counts the capped ones
+  void PrepareLFunctions();
+
+  //! Log-determinant from a single precision Cholesky factor R, corrected by
+  //! the Hutchinson estimate of log det(inv(R^T) L inv(R)). Returns false if
+  //! the factorization fails or if the correction does not converge.
+  bool GetSinglePrecisionLogDeterminant(const bool computeGradient, double &logDeterminant);
+
+  //! y = L x for vectors stored as the rows of x, so that the values at a
+  //! point are contiguous, with the entries of the dense L-matrix computed
+  //! on the fly
+  void MultiplyDenseLMatrix(const arma::mat &x, arma::mat &y);
+
+  //! Adds trace(inv(L) * dL) to the gradient of the log-determinant
+  template <class TMatrix>
+  void AccumulateGradientLogDeterminant(const TMatrix &inverseMatrix);
+
+  //! Entry of the L-matrix for a pair of labels 1-1 (labelPair = 0), 1-2 (1)
+  //! or 2-2 (2)
+  double EvaluateLEntry(const double sqDist, const unsigned int labelPair);
+
+  //! Entries of the sparse L-matrix between point i and its neighbours, in
+  //! the order of the neighbour lists
+  void EvaluateNeighbourLEntries(const unsigned int i, double *values, double *workValues);
+
+  //! Derivatives of the entries visited by VisitRowPairs(i), in the same
+  //! order. GetNumberOfRowPairs(i) gives the number of these entries.
+  void EvaluateRowLDerivatives(const unsigned int i, double *derivatives, double *workValues);
+  unsigned int GetNumberOfRowPairs(const unsigned int i) const;
+  unsigned int GetMaximalNumberOfRowPairs() const;
+
+  //! Radius beyond which the kernel with the largest admissible alpha stays
+  //! below the sparse tolerance relative to its value at the origin
+  double ComputeCutoffRadius(const arma::vec &lb, const arma::vec &ub);
+  void ComputeNeighbourPairs(const arma::mat &points, const arma::vec &lb, const arma::vec &ub);
+  void BuildSparseLMatrix();
+  double GetSparseLogDeterminant(const bool computeGradient);
+
+  //! Calls function(j, sqDist, labelPair) for the pairs (i, j), j > i, whose
+  //! entry is stored, either in the dense distance arrays or in the
+  //! neighbour lists of the sparse L-matrix
+  template <class TFunction>
+  void VisitRowPairs(const unsigned int i, TFunction &function);
+
+  //! y = L x for a block x of vectors, from the entries of the sparse
+  //! L-matrix stored in m_NeighbourValues
+  void MultiplySparseLMatrix(const arma::mat &x, arma::mat &y);
+  double GetStochasticLogDeterminant(const bool computeGradient);
+
+  //! Integral and log-determinant terms of the likelihood for the current
+  //! natural parameters, restored from the cache whenever possible. The
+  //! gradient of the log-determinant is only computed if needed.
+  void UpdateValues(const bool computeGradient);
 
   //! Generic variables used by all models but not needed in child classes
   double m_Integral, m_LogDeterminant;
   arma::vec m_GradientIntegral, m_GradientLogDeterminant;
-  NeighborhoodType m_Neighborhood;
   bool m_UsePeriodicDomain;
-  unsigned int m_SampleSize;
-  arma::mat m_DistanceMatrix;
+  unsigned int m_SampleSize, m_FirstSampleSize, m_SecondSampleSize;
+  double m_MaximalDistance;
+  arma::vec m_FirstSquaredDistances, m_CrossSquaredDistances, m_SecondSquaredDistances;
   arma::uvec m_PointLabels;
   arma::vec m_ConstraintVector;
   bool m_Modified;
   double m_DomainVolume;
+  double m_BesselJRatioTolerance;
+  BesselJRatioTable m_BesselJRatioTable;
+  unsigned int m_NumberOfThreads;
+
+  //! Sparse L-matrix: pairs closer than the cutoff radius stored row by row
+  //! (m_NeighbourStarts[i] to m_NeighbourStarts[i + 1] - 1 for point i) with
+  //! the larger index of each pair, its squared distance and the position of
+  //! its entry in the envelope of the factorization
+  double m_SparseTolerance, m_CutoffRadius, m_NeighbourRadius;
+  bool m_UseSparseLMatrix, m_ValidLogDeterminant;
+  std::vector<unsigned int> m_NeighbourStarts, m_NeighbourIndices;
+  unsigned int m_MaximalNumberOfNeighbours;
+  arma::vec m_NeighbourSquaredDistances;
+  std::vector<arma::uword> m_NeighbourPositions, m_DiagonalPositions;
+  EnvelopeCholesky m_SparseFactor;
+
+  //! Stochastic log-determinant: with the sparse L-matrix, its off-diagonal
+  //! entries are kept in m_NeighbourValues instead of the envelope
+  unsigned int m_NumberOfProbes;
+  double m_LogDeterminantError;
+  arma::vec m_NeighbourValues;
+  StochasticLogDeterminant m_StochasticEstimator;
+
+  //! Single precision L-matrix and the probes of its correction
+  bool m_UseSinglePrecision;
+  unsigned int m_NumberOfCorrectionProbes;
+  uint64_t m_ProbeSeed;
+
+  //! Evaluations keyed on the natural parameters. The integral always comes
+  //! with its gradient, so an entry only lacking the gradient of the
+  //! log-determinant is completed without integrating again.
+  struct CachedValues
+  {
+    double m_Integral, m_LogDeterminant, m_LogDeterminantError;
+    arma::vec m_GradientIntegral, m_GradientLogDeterminant;
+    bool m_ValidLogDeterminant, m_HasGradient;
+  };
+  ParameterCache<CachedValues> m_EvaluationCache;
+
+  EvaluationProfiler m_Profiler;
+
+  //! Evaluations whose L functions hit the size caps, and whether it was
+  //! reported
+  unsigned int m_NumberOfCappedLFunctions;
+  bool m_CappedLFunctionsWarned;
 
   //! Generic variables used by all models and needed in each child class
   unsigned int m_DomainDimension;
@@ -146,7 +493,70 @@ private:
   double m_FirstAmplitude, m_CrossAmplitude, m_SecondAmplitude;
   double m_NormalizedCrossAmplitude;
   double m_InverseCrossAlpha;
+  double m_AlphaUpperBound;
   bool m_EstimateIntensities;
 
   static const double m_Epsilon;
 };
+
+template <class TFunction>
+void BaseLogLikelihood::VisitRowPairs(const unsigned int i, TFunction &function)
+{
+  unsigned int n1 = m_FirstSampleSize;
+  unsigned int n2 = m_SecondSampleSize;
+  unsigned int firstLabel = (i < n1) ? 0 : 1;
+
+  if (m_UseSparseLMatrix)
+  {
+    for (unsigned int p = m_NeighbourStarts[i];p < m_NeighbourStarts[i + 1];++p)
+    {
+      unsigned int j = m_NeighbourIndices[p];
+      function(j, m_NeighbourSquaredDistances[p], firstLabel + ((j < n1) ? 0 : 1));
+    }
+
+    return;
+  }
+
+  if (firstLabel == 1)
+  {
+    const double *sqDistances = m_SecondSquaredDistances.memptr() + this->GetPackedRowOffset(i - n1, n2);
+    for (unsigned int j = i + 1;j < n1 + n2;++j)
+      function(j, sqDistances[j - i - 1], 2);
+
+    return;
+  }
+
+  const double *sqDistances = m_FirstSquaredDistances.memptr() + this->GetPackedRowOffset(i, n1);
+  for (unsigned int j = i + 1;j < n1;++j)
+    function(j, sqDistances[j - i - 1], 0);
+
+  sqDistances = m_CrossSquaredDistances.memptr() + (arma::uword)i * n2;
+  for (unsigned int j = 0;j < n2;++j)
+    function(n1 + j, sqDistances[j], 1);
+}
+
+template <unsigned int TDimension>
+double BaseLogLikelihood::GetBesselJRatio(const double sqDist, const double alpha, const bool cross)
+{
+  // if cross is true, alpha is in fact its inverse
+  double tmpVal = (cross) ? alpha : 1.0 / alpha;
+  tmpVal *= DimensionTraits<TDimension>::m_SqrtTwiceDimension * std::sqrt(sqDist);
+
+  if (m_BesselJRatioTable.IsBuilt())
+    return m_BesselJRatioTable.Evaluate(tmpVal);
+
+  return DimensionTraits<TDimension>::GetBesselJRatio(tmpVal);
+}
+
+template <unsigned int TDimension>
+double BaseLogLikelihood::GetBesselJRatioDerivative(const double sqDist, const double alpha, const bool cross)
+{
+  double tmpVal = (cross) ? alpha : 1.0 / alpha;
+  tmpVal *= DimensionTraits<TDimension>::m_SqrtTwiceDimension * std::sqrt(sqDist);
+  double derivArgument = (cross) ? tmpVal / alpha : -tmpVal / alpha;
+
+  if (m_BesselJRatioTable.IsBuilt())
+    return m_BesselJRatioTable.EvaluateDerivative(tmpVal) * derivArgument;
+
+  return DimensionTraits<TDimension>::GetBesselJRatioDerivative(tmpVal) * derivArgument;
+}
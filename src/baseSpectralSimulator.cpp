@@ -0,0 +1,244 @@
+#include "baseSpectralSimulator.h"
+#include "projectionSampler.h"
+#include <algorithm>
+#include <stdexcept>
+
+void BaseSpectralSimulator::SetDomain(const arma::vec &lb, const arma::vec &ub)
+{
+  m_LowerBounds = lb;
+  m_BoxLengths = ub - lb;
+  m_DomainVolume = 1.0;
+  m_UseCubicSymmetry = true;
+
+  for (unsigned int i = 0;i < m_BoxLengths.n_elem;++i)
+  {
+    m_DomainVolume *= m_BoxLengths[i];
+
+    if (m_BoxLengths[i] != m_BoxLengths[0])
+      m_UseCubicSymmetry = false;
+  }
+
+  m_Modified = true;
+}
+
+void BaseSpectralSimulator::SetParameters(
+    const double rho1,
+    const double rho2,
+    const double alpha1,
+    const double alpha2,
+    const double alpha12,
+    const double tau)
+{
+  m_Intensities[0] = rho1;
+  m_Intensities[1] = rho2;
+  m_Alphas[0] = alpha1;
+  m_Alphas[1] = 1.0 / alpha12;
+  m_Alphas[2] = alpha2;
+  m_Correlation = tau;
+  m_Modified = true;
+}
+
+bool BaseSpectralSimulator::IncrementFrequency(std::vector<int> &frequency) const
+{
+  int truncation = (int)m_Truncation;
+
+  for (unsigned int l = 0;l < frequency.size();++l)
+  {
+    if (frequency[l] < truncation)
+    {
+      ++frequency[l];
+      return true;
+    }
+
+    frequency[l] = -truncation;
+  }
+
+  return false;
+}
+
+bool BaseSpectralSimulator::IncrementCanonicalFrequency(std::vector<int> &frequency) const
+{
+  unsigned int dimension = frequency.size();
+
+  for (unsigned int l = 0;l < dimension;++l)
+  {
+    int upperBound = (m_UseCubicSymmetry && l + 1 < dimension) ? frequency[l + 1] : (int)m_Truncation;
+
+    if (frequency[l] < upperBound)
+    {
+      ++frequency[l];
+      return true;
+    }
+
+    frequency[l] = 0;
+  }
+
+  return false;
+}
+
+double BaseSpectralSimulator::GetMultiplicity(const std::vector<int> &frequency) const
+{
+  // Sign changes of the non-zero coordinates, then distinct permutations
+  // d! / (r_1! ... r_s!) of the sorted coordinates with runs of length r_j
+  double resVal = 1.0;
+
+  for (unsigned int l = 0;l < frequency.size();++l)
+  {
+    if (frequency[l] != 0)
+      resVal *= 2.0;
+  }
+
+  if (!m_UseCubicSymmetry)
+    return resVal;
+
+  unsigned int runLength = 1;
+  for (unsigned int l = 1;l < frequency.size();++l)
+  {
+    resVal *= (double)(l + 1);
+
+    if (frequency[l] == frequency[l - 1])
+    {
+      ++runLength;
+      resVal /= (double)runLength;
+    }
+    else
+      runLength = 1;
+  }
+
+  return resVal;
+}
+
+unsigned int BaseSpectralSimulator::GetCanonicalIndex(const std::vector<int> &frequency, std::vector<int> &workFrequency) const
+{
+  unsigned int dimension = frequency.size();
+
+  for (unsigned int l = 0;l < dimension;++l)
+    workFrequency[l] = std::abs(frequency[l]);
+
+  if (m_UseCubicSymmetry)
+    std::sort(workFrequency.begin(), workFrequency.end());
+
+  unsigned int resVal = 0;
+  for (unsigned int l = dimension;l > 0;--l)
+    resVal = resVal * (m_Truncation + 1) + workFrequency[l - 1];
+
+  return resVal;
+}
+
+void BaseSpectralSimulator::GetSpectralMatrix(const std::vector<int> &frequency, double &k11, double &k12, double &k22) const
+{
+  unsigned int dimension = frequency.size();
+  double sqRadius = 0.0;
+
+  for (unsigned int l = 0;l < dimension;++l)
+  {
+    double workValue = (double)frequency[l] / m_BoxLengths[l];
+    sqRadius += workValue * workValue;
+  }
+
+  double radius = std::sqrt(sqRadius);
+  k11 = m_Amplitudes[0] * this->GetFourierKernel(radius, m_Alphas[0], false);
+  k12 = m_Amplitudes[1] * this->GetFourierKernel(radius, m_Alphas[1], true);
+  k22 = m_Amplitudes[2] * this->GetFourierKernel(radius, m_Alphas[2], false);
+}
+
+void BaseSpectralSimulator::ComputeTruncation()
+{
+  // The trace of the spectral matrices sums to the expected number of
+  // points over all frequencies.
+  unsigned int dimension = this->GetDomainDimension();
+  double expectedNumber = m_DomainVolume * (m_Intensities[0] + m_Intensities[1]);
+  double precision = 0.0;
+  m_Truncation = 1;
+
+  while (precision <= m_Precision && 2 * m_Truncation <= m_MaximalTruncation)
+  {
+    m_Truncation *= 2;
+    std::vector<int> frequency(dimension, 0);
+    double traceValue = 0.0;
+
+    do
+    {
+      double k11 = 0.0, k12 = 0.0, k22 = 0.0;
+      this->GetSpectralMatrix(frequency, k11, k12, k22);
+      traceValue += this->GetMultiplicity(frequency) * (k11 + k22);
+    }
+    while (this->IncrementCanonicalFrequency(frequency));
+
+    precision = traceValue / expectedNumber;
+  }
+}
+
+void BaseSpectralSimulator::ComputeSpectralDecomposition()
+{
+  unsigned int dimension = this->GetDomainDimension();
+  double crossIntensity = m_Correlation * std::sqrt(m_Intensities[0] * m_Intensities[1]);
+  m_Amplitudes[0] = this->GetAmplitude(m_Intensities[0], m_Alphas[0]);
+  m_Amplitudes[1] = this->GetAmplitude(crossIntensity, 1.0 / m_Alphas[1]);
+  m_Amplitudes[2] = this->GetAmplitude(m_Intensities[1], m_Alphas[2]);
+
+  this->ComputeTruncation();
+
+  unsigned int tableSize = 1;
+  for (unsigned int l = 0;l < dimension;++l)
+    tableSize *= m_Truncation + 1;
+
+  m_SpectralDecompositions.assign(4 * tableSize, 0.0);
+  m_NumberOfDecompositions = 0;
+
+  std::vector<int> frequency(dimension, 0), workFrequency(dimension);
+
+  do
+  {
+    double k11 = 0.0, k12 = 0.0, k22 = 0.0;
+    this->GetSpectralMatrix(frequency, k11, k12, k22);
+
+    // Closed-form eigen-decomposition of [k11 k12; k12 k22]
+    double meanValue = (k11 + k22) / 2.0;
+    double halfDifference = (k11 - k22) / 2.0;
+    double radiusValue = std::sqrt(halfDifference * halfDifference + k12 * k12);
+    double angleValue = 0.5 * std::atan2(k12, halfDifference);
+    double *workValues = &(m_SpectralDecompositions[4 * this->GetCanonicalIndex(frequency, workFrequency)]);
+    workValues[0] = meanValue + radiusValue;
+    workValues[1] = meanValue - radiusValue;
+    workValues[2] = std::cos(angleValue);
+    workValues[3] = std::sin(angleValue);
+
+    if (workValues[0] > 1.0 + m_EigenValueTolerance || workValues[1] < -m_EigenValueTolerance)
+      throw std::runtime_error("The parameters do not define a valid DPP: the spectral eigenvalues should lie in [0, 1].");
+
+    ++m_NumberOfDecompositions;
+  }
+  while (this->IncrementCanonicalFrequency(frequency));
+
+  m_Modified = false;
+}
+
+void BaseSpectralSimulator::Generate(arma::mat &points, arma::uvec &labels, PhiloxGenerator &generator) const
+{
+  if (m_Modified)
+    throw std::runtime_error("The spectral decomposition should be computed before generating points.");
+
+  unsigned int dimension = this->GetDomainDimension();
+  ProjectionSampler sampler;
+  sampler.SetDomain(m_LowerBounds, m_BoxLengths);
+  sampler.SetTruncation(m_Truncation);
+  sampler.SetMaximalNumberOfRejections(m_MaximalNumberOfRejections);
+
+  // Each eigenpair is kept with probability its eigenvalue.
+  std::vector<int> frequency(dimension, -(int)m_Truncation), workFrequency(dimension);
+
+  do
+  {
+    const double *workValues = &(m_SpectralDecompositions[4 * this->GetCanonicalIndex(frequency, workFrequency)]);
+
+    if (generator.GetUniform() < workValues[0])
+      sampler.AddEigenPair(frequency, workValues[2], workValues[3]);
+
+    if (generator.GetUniform() < workValues[1])
+      sampler.AddEigenPair(frequency, -workValues[3], workValues[2]);
+  }
+  while (this->IncrementFrequency(frequency));
+
+  sampler.Generate(points, labels, generator);
+}
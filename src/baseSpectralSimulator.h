@@ -0,0 +1,107 @@
+#pragma once
+
+#include <RcppEnsmallen.h>
+#include "philoxGenerator.h"
+
+//! Spectral simulation of a stationary bivariate DPP on a rectangular domain.
+//! The kernel is replaced by its Fourier series truncated to the frequencies
+//! in [-N, N]^d, where N is the smallest power of two capturing the requested
+//! fraction of the expected number of points. At each frequency, the 2 x 2
+//! spectral matrix is diagonalized in closed form and each eigenpair is kept
+//! with probability its eigenvalue before sampling the resulting projection
+//! DPP with ProjectionSampler.
+//!
+//! The truncation and the spectral decompositions only depend on the
+//! parameters and are computed once by ComputeSpectralDecomposition(), after
+//! which Generate() can be called repeatedly. Since the spectral matrices are
+//! radial, they are computed for the frequencies with non-negative
+//! coordinates only, sorted in increasing order when the domain is a cube.
+class BaseSpectralSimulator
+{
+public:
+  BaseSpectralSimulator()
+  {
+    m_Precision = 0.99;
+    m_MaximalTruncation = 1000;
+    m_MaximalNumberOfRejections = 10000;
+    m_Truncation = 0;
+    m_DomainVolume = 0.0;
+    m_Correlation = 0.0;
+    m_UseCubicSymmetry = false;
+    m_Modified = true;
+    m_NumberOfDecompositions = 0;
+  }
+
+  virtual ~BaseSpectralSimulator() {}
+
+  void SetDomain(const arma::vec &lb, const arma::vec &ub);
+
+  //! Marginal intensities, alpha parameters and correlation tau of the model
+  void SetParameters(
+      const double rho1,
+      const double rho2,
+      const double alpha1,
+      const double alpha2,
+      const double alpha12,
+      const double tau
+  );
+
+  void SetPrecision(const double x) {m_Precision = x; m_Modified = true;}
+  void SetMaximalTruncation(const unsigned int x) {m_MaximalTruncation = x; m_Modified = true;}
+  void SetMaximalNumberOfRejections(const unsigned int x) {m_MaximalNumberOfRejections = x;}
+  unsigned int GetTruncation() const {return m_Truncation;}
+  unsigned int GetDomainDimension() const {return m_BoxLengths.n_elem;}
+
+  //! Number of spectral decompositions actually computed
+  unsigned int GetNumberOfDecompositions() const {return m_NumberOfDecompositions;}
+
+  void ComputeSpectralDecomposition();
+
+  //! Points are returned row-wise with labels 1 or 2. All random numbers
+  //! are drawn from the given generator, so that concurrent calls with
+  //! distinct generators are safe.
+  void Generate(arma::mat &points, arma::uvec &labels, PhiloxGenerator &generator) const;
+
+protected:
+  virtual double GetFourierKernel(const double radius, const double alpha, const bool cross) const = 0;
+  virtual double GetAmplitude(const double intensity, const double alpha) = 0;
+
+private:
+  //! Moves to the next frequency of [-N, N]^d in lexicographic order
+  bool IncrementFrequency(std::vector<int> &frequency) const;
+
+  //! Moves to the next frequency of [0, N]^d, with non-decreasing
+  //! coordinates when the domain is a cube
+  bool IncrementCanonicalFrequency(std::vector<int> &frequency) const;
+
+  //! Number of frequencies of [-N, N]^d sharing the given canonical one
+  double GetMultiplicity(const std::vector<int> &frequency) const;
+
+  //! Position in the table of spectral decompositions of the canonical
+  //! frequency (|k_1|, ..., |k_d|), sorted when the domain is a cube
+  unsigned int GetCanonicalIndex(const std::vector<int> &frequency, std::vector<int> &workFrequency) const;
+
+  void GetSpectralMatrix(const std::vector<int> &frequency, double &k11, double &k12, double &k22) const;
+  void ComputeTruncation();
+
+  //! alpha1, 1 / alpha12 and alpha2 followed by the matching amplitudes
+  double m_Alphas[3];
+  double m_Amplitudes[3];
+  double m_Intensities[2];
+  double m_Correlation;
+  double m_Precision;
+  double m_DomainVolume;
+  arma::vec m_LowerBounds, m_BoxLengths;
+  unsigned int m_MaximalTruncation, m_MaximalNumberOfRejections;
+  unsigned int m_Truncation;
+  bool m_UseCubicSymmetry;
+  bool m_Modified;
+
+  //! Eigenvalues and eigenvectors (cos t, sin t) and (-sin t, cos t) of the
+  //! spectral matrices, stored as (lambda1, lambda2, cos t, sin t) for each
+  //! canonical frequency of [0, N]^d
+  std::vector<double> m_SpectralDecompositions;
+  unsigned int m_NumberOfDecompositions;
+
+  static constexpr double m_EigenValueTolerance = 1.0e-8;
+};
@@ -1,13 +1,75 @@
 #include <RcppEnsmallen.h>
 #include "besselLogLikelihood.h"
+#include "besselJRatioTable.h"
+#include "boxConstrainedFunction.h"
+#include <stdexcept>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static void MinimizeWithLBFGS(BesselLogLikelihood &logLik, arma::mat &params)
+{
+  // L-BFGS is unconstrained: the search space is mapped onto the real line.
+  arma::vec lowerBounds, upperBounds;
+  logLik.GetParameterBounds(lowerBounds, upperBounds);
+  BoxConstrainedFunction<BesselLogLikelihood> boxLogLik(logLik, lowerBounds, upperBounds);
+
+  arma::mat workParams = boxLogLik.GetUnconstrainedPoint(params);
+  ens::L_BFGS optimizer;
+  optimizer.Optimize(boxLogLik, workParams);
+  params = boxLogLik.GetConstrainedPoint(workParams);
+}
 
 //' Stationary Bivariate Bessel DPP Estimator
 //'
 //' This function estimates the parameters of a stationary bivariate Gaussian DPP from a set of observed points and labels.
 //'
 //' @param X A matrix of size n x (d+1) storing the points in R^d and their label in last column.
+//' @param interpolation_tolerance Absolute accuracy of the lookup table used
+//'   to evaluate the Bessel kernels. If non-positive (default), they are
+//'   computed exactly.
+//' @param num_threads Number of threads used for building the distance and
+//'   L matrices (default: 1).
+//' @param method Optimization method: either `"lbfgs"` (default) which uses
+//'   the analytic gradient of the log-likelihood, or `"sa"` for simulated
+//'   annealing, which was the only method and hence the default in earlier
+//'   versions.
+//' @param sparse_tolerance If positive, entries of the L-matrix are dropped
+//'   beyond the distance where the widest admissible kernel falls below this
+//'   fraction of its value at the origin, and the log-likelihood is computed
+//'   by a sparse Cholesky factorization (default: 0, i.e. dense).
+//' @param num_probes If positive, the log-determinant of the L-matrix and its
+//'   gradient are estimated by stochastic Lanczos quadrature with this number
+//'   of random probes, which only requires products with the L-matrix. Best
+//'   combined with `sparse_tolerance` for large patterns (default: 0, i.e.
+//'   exact). Each probe runs a fixed number of Lanczos steps, so that the
+//'   estimated log-likelihood is smooth in the parameters. Its gradient is a
+//'   separate stochastic estimate, not the derivative of the estimated
+//'   log-likelihood, so that the optimizer sees a slightly inconsistent pair.
+//' @param single_precision Whether to assemble and factorize the dense
+//'   L-matrix in single precision, which halves its memory footprint, and to
+//'   correct the resulting log-determinant in double precision from random
+//'   probes. This saves memory only: the factorization does not use LAPACK
+//'   and is slower than the double precision one. The error reported for the
+//'   correction is its standard error over the probes plus an estimate of the
+//'   truncation of its series from the same probes, neither being a bound.
+//'   The gradient is approximate since it comes from the uncorrected single
+//'   precision inverse. Ignored with `sparse_tolerance` or `num_probes`
+//'   (default: `FALSE`).
+//' @param num_correction_probes Number of random probes of the single
+//'   precision correction (default: 16).
+//' @param verbose Whether to print the initial and final parameters along
+//'   with the duration of the estimation (default: `FALSE`).
+//' @param profile Whether to count the evaluations and time their phases
+//'   (default: `FALSE`).
 //'
-//' @return A vector with the estimated model parameters.
+//' @return A vector with the estimated model parameters. With `profile =
+//'   TRUE`, its `profile` attribute is a list storing the number of
+//'   evaluations, of cache hits, of spectral integrals and of their
+//'   quadrature nodes and of log-determinants, along with the time in
+//'   seconds spent preparing the inputs, integrating, assembling the L-matrix
+//'   and computing its log-determinant (assembly included).
 //'
 //' @export
 //' @examples
@@ -31,7 +93,7 @@
 //'   estimate_alpha = FALSE
 //' )
 // [[Rcpp::export]]
-arma::mat EstimateBessel(
+Rcpp::NumericMatrix EstimateBessel(
     const arma::mat &X,
     const arma::uvec &labels,
     const arma::vec &lb,
@@ -40,17 +102,33 @@ arma::mat EstimateBessel(
     const double rho2 = NA_REAL,
     const double alpha1 = NA_REAL,
     const double alpha2 = NA_REAL,
-    const bool estimate_alpha = true)
+    const bool estimate_alpha = true,
+    const double interpolation_tolerance = 0.0,
+    const unsigned int num_threads = 1,
+    const std::string method = "lbfgs",
+    const double sparse_tolerance = 0.0,
+    const unsigned int num_probes = 0,
+    const bool single_precision = false,
+    const unsigned int num_correction_probes = 16,
+    const bool verbose = false,
+    const bool profile = false)
 {
+  if (method != "lbfgs" && method != "sa")
+    Rcpp::stop("The optimization method should be either lbfgs or sa.");
+
   // Construct the objective function.
   BesselLogLikelihood logLik;
+  logLik.SetBesselJRatioTolerance(interpolation_tolerance);
+  logLik.SetNumberOfThreads(num_threads);
+  logLik.SetSparseTolerance(sparse_tolerance);
+  logLik.SetNumberOfProbes(num_probes);
+  logLik.SetSinglePrecision(single_precision);
+  logLik.SetNumberOfCorrectionProbes(num_correction_probes);
+  logLik.SetProfiling(profile);
   logLik.SetInputs(X, labels, lb, ub);
 
-  // Create the optimizer.
-  // ens::DE optimizer(1000, 1000, 0.6, 0.8, 1e-5);
-  ens::ExponentialSchedule expSchedule;
-  ens::SA<> optimizer(expSchedule);//, 1000000, 1000., 1000, 100, 1e-10, 3, 1.5, 0.5, 0.3);
-  // ens::CNE optimizer(200, 10000, 0.2, 0.2, 0.3, 1e-5);
+  if (arma::is_finite(rho1) & arma::is_finite(rho2))
+    logLik.SetIntensities(rho1, rho2);
 
   // Create a starting point for our optimization randomly within the
   // authorized search space.
@@ -61,15 +139,198 @@ arma::mat EstimateBessel(
   clock.tic();
 
   // Run the optimization
-  Rcpp::Rcout << "Initial parameters: " << params.as_row() << std::endl;
-  optimizer.Optimize(logLik, params);
-  Rcpp::Rcout << "Final parameters: " << params.as_row() << std::endl;
+  if (verbose)
+    Rcpp::Rcout << "Initial parameters: " << params.as_row() << std::endl;
 
-  // End time output
-  Rcpp::Rcout << "Estimation performed in " << clock.toc() << " seconds." << std::endl;
-  Rcpp::Rcout << "Min: " << logLik.Evaluate(params) << std::endl;
+  if (method == "sa")
+  {
+    ens::ExponentialSchedule expSchedule;
+    ens::SA<> optimizer(expSchedule);
+    optimizer.Optimize(logLik, params);
+  }
+  else
+    MinimizeWithLBFGS(logLik, params);
 
-  return params;
+  if (verbose)
+  {
+    Rcpp::Rcout << "Final parameters: " << params.as_row() << std::endl;
+    Rcpp::Rcout << "Estimation performed in " << clock.toc() << " seconds." << std::endl;
+    Rcpp::Rcout << "Min: " << logLik.Evaluate(params) << std::endl;
+  }
+
+  Rcpp::NumericMatrix resMat = Rcpp::wrap(params);
+  if (profile)
+    resMat.attr("profile") = logLik.GetProfile();
+
+  return resMat;
+}
+
+//' Batch Estimation of Stationary Bivariate Bessel DPPs
+//'
+//' This function fits a stationary bivariate Bessel DPP to each pattern of a
+//' list, possibly from several starting points, by running the L-BFGS
+//' estimations concurrently. Each fit uses its own log-likelihood object.
+//'
+//' @param X_list A list of matrices of size n_i x d storing the points in R^d
+//'   of each pattern.
+//' @param labels_list A list of vectors storing the labels of the points of
+//'   each pattern.
+//' @param lb A d-dimensional vector storing the lower bounds of the spatial
+//'   domain.
+//' @param ub A d-dimensional vector storing the upper bounds of the spatial
+//'   domain.
+//' @param rho1 A vector with the first intensity of each pattern, or a single
+//'   value shared by all patterns. If `NA`, intensities are estimated.
+//' @param rho2 A vector with the second intensity of each pattern, or a single
+//'   value shared by all patterns. If `NA`, intensities are estimated.
+//' @param starting_points A matrix storing one starting point per column.
+//'   Each pattern is fitted from each of them and the best fit is kept. If it
+//'   has no column, the midpoint of the search space is used.
+//' @param interpolation_tolerance Absolute accuracy of the lookup table used
+//'   to evaluate the Bessel kernels. If non-positive (default), they are
+//'   computed exactly.
+//' @param num_threads Number of fits run concurrently (default: 1).
+//' @param sparse_tolerance Relative kernel tolerance below which entries of
+//'   the L-matrix are dropped (default: 0, i.e. dense). See
+//'   [EstimateBessel()].
+//' @param num_probes Number of probes of the stochastic log-determinant
+//'   (default: 0, i.e. exact). See [EstimateBessel()].
+//' @param single_precision Whether to factorize the L-matrix in single
+//'   precision (default: `FALSE`). See [EstimateBessel()].
+//' @param num_correction_probes Number of probes of the single precision
+//'   correction (default: 16). See [EstimateBessel()].
+//'
+//' @return A matrix with one row per pattern storing the estimated parameters
+//'   followed by the minimal value of the objective function. Rows of failed
+//'   fits are set to `NA`.
+//'
+//' @export
+// [[Rcpp::export]]
+arma::mat EstimateBesselBatch(
+    const Rcpp::List &X_list,
+    const Rcpp::List &labels_list,
+    const arma::vec &lb,
+    const arma::vec &ub,
+    const arma::vec &rho1,
+    const arma::vec &rho2,
+    const arma::mat &starting_points,
+    const double interpolation_tolerance = 0.0,
+    const unsigned int num_threads = 1,
+    const double sparse_tolerance = 0.0,
+    const unsigned int num_probes = 0,
+    const bool single_precision = false,
+    const unsigned int num_correction_probes = 16)
+{
+  unsigned int numPatterns = X_list.size();
+
+  if (labels_list.size() != (int)numPatterns)
+    Rcpp::stop("The lists of points and labels should have the same length.");
+
+  if ((rho1.n_elem != 1 && rho1.n_elem != numPatterns) || rho1.n_elem != rho2.n_elem)
+    Rcpp::stop("The intensities should be given either once or for each pattern.");
+
+  // Intensities are either all fixed or all estimated so that all fits share
+  // the same parameters.
+  bool estimateIntensities = !arma::is_finite(rho1[0]);
+  for (unsigned int i = 0;i < rho1.n_elem;++i)
+  {
+    if (arma::is_finite(rho1[i]) != arma::is_finite(rho2[i]) || arma::is_finite(rho1[i]) == estimateIntensities)
+      Rcpp::stop("The intensities should be either all set or all missing.");
+  }
+
+  unsigned int numParams = (estimateIntensities) ? 6 : 4;
+  unsigned int numStarts = std::max(starting_points.n_cols, (arma::uword)1);
+
+  if (starting_points.n_cols > 0 && starting_points.n_rows != numParams)
+    Rcpp::stop("The starting points should have %d rows.", numParams);
+
+  // R objects cannot be accessed from the worker threads.
+  std::vector<arma::mat> pointsVector(numPatterns);
+  std::vector<arma::uvec> labelsVector(numPatterns);
+  for (unsigned int i = 0;i < numPatterns;++i)
+  {
+    pointsVector[i] = Rcpp::as<arma::mat>(X_list[i]);
+    labelsVector[i] = Rcpp::as<arma::uvec>(labels_list[i]);
+  }
+
+  // One task per pattern and starting point; the best fit of each pattern is
+  // selected afterwards.
+  unsigned int numTasks = numPatterns * numStarts;
+  arma::mat taskResults(numParams + 1, numTasks);
+  taskResults.fill(NA_REAL);
+  std::vector<std::string> taskErrors(numTasks);
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+#endif
+  for (unsigned int k = 0;k < numTasks;++k)
+  {
+    unsigned int i = k / numStarts;
+    unsigned int j = k % numStarts;
+
+    try
+    {
+      BesselLogLikelihood logLik;
+      logLik.SetBesselJRatioTolerance(interpolation_tolerance);
+      logLik.SetSparseTolerance(sparse_tolerance);
+      logLik.SetNumberOfProbes(num_probes);
+      logLik.SetSinglePrecision(single_precision);
+      logLik.SetNumberOfCorrectionProbes(num_correction_probes);
+      logLik.SetInputs(pointsVector[i], labelsVector[i], lb, ub);
+
+      if (!estimateIntensities)
+      {
+        unsigned int pos = (rho1.n_elem == 1) ? 0 : i;
+        logLik.SetIntensities(rho1[pos], rho2[pos]);
+      }
+
+      arma::mat params = logLik.GetInitialPoint();
+      if (starting_points.n_cols > 0)
+        params = starting_points.col(j);
+
+      MinimizeWithLBFGS(logLik, params);
+
+      for (unsigned int l = 0;l < numParams;++l)
+        taskResults(l, k) = params[l];
+      taskResults(numParams, k) = logLik.Evaluate(params);
+    }
+    catch (std::exception &e)
+    {
+      taskErrors[k] = e.what();
+    }
+  }
+
+  arma::mat resMat(numPatterns, numParams + 1);
+  resMat.fill(NA_REAL);
+  unsigned int numFailures = 0;
+  std::string firstError;
+
+  for (unsigned int i = 0;i < numPatterns;++i)
+  {
+    for (unsigned int j = 0;j < numStarts;++j)
+    {
+      unsigned int k = i * numStarts + j;
+
+      if (!taskErrors[k].empty())
+      {
+        if (numFailures == 0)
+          firstError = taskErrors[k];
+        ++numFailures;
+        continue;
+      }
+
+      if (!arma::is_finite(resMat(i, numParams)) || taskResults(numParams, k) < resMat(i, numParams))
+      {
+        for (unsigned int l = 0;l <= numParams;++l)
+          resMat(i, l) = taskResults(l, k);
+      }
+    }
+  }
+
+  if (numFailures > 0)
+    Rcpp::warning("%d fits failed, the first one with: %s", numFailures, firstError);
+
+  return resMat;
 }
 
 // [[Rcpp::export]]
@@ -80,10 +341,22 @@ double EvaluateBessel(
     const arma::vec &lb,
     const arma::vec &ub,
     const double rho1 = NA_REAL,
-    const double rho2 = NA_REAL)
+    const double rho2 = NA_REAL,
+    const double interpolation_tolerance = 0.0,
+    const unsigned int num_threads = 1,
+    const double sparse_tolerance = 0.0,
+    const unsigned int num_probes = 0,
+    const bool single_precision = false,
+    const unsigned int num_correction_probes = 16)
 {
   // Construct the objective function.
   BesselLogLikelihood logLik;
+  logLik.SetBesselJRatioTolerance(interpolation_tolerance);
+  logLik.SetNumberOfThreads(num_threads);
+  logLik.SetSparseTolerance(sparse_tolerance);
+  logLik.SetNumberOfProbes(num_probes);
+  logLik.SetSinglePrecision(single_precision);
+  logLik.SetNumberOfCorrectionProbes(num_correction_probes);
   logLik.SetInputs(X, labels, lb, ub);
 
   if (arma::is_finite(rho1) & arma::is_finite(rho2))
@@ -96,6 +369,41 @@ double EvaluateBessel(
   return logLik.Evaluate(params);
 }
 
+// [[Rcpp::export]]
+SEXP CreateBesselLogLikelihood(
+    const arma::mat &X,
+    const arma::uvec &labels,
+    const arma::vec &lb,
+    const arma::vec &ub,
+    const double rho1 = NA_REAL,
+    const double rho2 = NA_REAL,
+    const double interpolation_tolerance = 0.0,
+    const unsigned int num_threads = 1,
+    const double sparse_tolerance = 0.0,
+    const unsigned int num_probes = 0,
+    const bool single_precision = false,
+    const unsigned int num_correction_probes = 16,
+    const bool profile = false)
+{
+  // Construct the objective function once so that the distance matrix is
+  // shared by all subsequent evaluations.
+  BesselLogLikelihood *logLik = new BesselLogLikelihood;
+  Rcpp::XPtr<BaseLogLikelihood> logLikPtr(logLik, true);
+  logLik->SetBesselJRatioTolerance(interpolation_tolerance);
+  logLik->SetNumberOfThreads(num_threads);
+  logLik->SetSparseTolerance(sparse_tolerance);
+  logLik->SetNumberOfProbes(num_probes);
+  logLik->SetSinglePrecision(single_precision);
+  logLik->SetNumberOfCorrectionProbes(num_correction_probes);
+  logLik->SetProfiling(profile);
+  logLik->SetInputs(X, labels, lb, ub);
+
+  if (arma::is_finite(rho1) & arma::is_finite(rho2))
+    logLik->SetIntensities(rho1, rho2);
+
+  return logLikPtr;
+}
+
 // [[Rcpp::export]]
 arma::mat InitializeBessel(
     const arma::mat &X,
@@ -113,3 +421,41 @@ arma::mat InitializeBessel(
   logLik.SetInputs(X, labels, lb, ub);
   return logLik.GetInitialPoint();
 }
+
+// [[Rcpp::export]]
+Rcpp::List CompareBesselJRatio(
+    const arma::vec &x,
+    const unsigned int dimension = 2,
+    const double tolerance = 1.0e-10)
+{
+  // Accuracy and speed of the lookup table against boost on the given
+  // arguments of the Bessel J ratio.
+  double order = (double)dimension / 2.0;
+  unsigned int numValues = x.n_elem;
+  arma::vec exactValues(numValues), tableValues(numValues);
+
+  arma::wall_clock clock;
+  clock.tic();
+  BesselJRatioTable table;
+  table.Build(order, tolerance);
+  double buildTime = clock.toc();
+
+  clock.tic();
+  for (unsigned int i = 0;i < numValues;++i)
+    exactValues[i] = BesselJRatioTable::GetExactValue(x[i], order);
+  double exactTime = clock.toc();
+
+  clock.tic();
+  for (unsigned int i = 0;i < numValues;++i)
+    tableValues[i] = table.Evaluate(x[i]);
+  double tableTime = clock.toc();
+
+  return Rcpp::List::create(
+    Rcpp::Named("max_error") = arma::max(arma::abs(tableValues - exactValues)),
+    Rcpp::Named("exact_time") = exactTime,
+    Rcpp::Named("table_time") = tableTime,
+    Rcpp::Named("build_time") = buildTime,
+    Rcpp::Named("number_of_nodes") = table.GetNumberOfNodes(),
+    Rcpp::Named("asymptotic_threshold") = table.GetAsymptoticThreshold()
+  );
+}
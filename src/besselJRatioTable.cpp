@@ -0,0 +1,162 @@
+#include "besselJRatioTable.h"
+#include <boost/math/special_functions/bessel.hpp>
+#include <boost/math/special_functions/gamma.hpp>
+
+const unsigned int BesselJRatioTable::m_NumberOfHankelTerms = 8;
+const double BesselJRatioTable::m_MinimalAsymptoticThreshold = 10.0;
+
+double BesselJRatioTable::GetExactValue(const double x, const double order)
+{
+  if (x < std::sqrt(std::numeric_limits<double>::epsilon()))
+    return 1.0 / boost::math::tgamma(1.0 + order);
+
+  return boost::math::cyl_bessel_j(order, x) / std::pow(x / 2.0, order);
+}
+
+double BesselJRatioTable::GetExactDerivative(const double x, const double order)
+{
+  // d/dx [J_nu(x) / (x / 2)^nu] = -(x / 2) J_{nu + 1}(x) / (x / 2)^{nu + 1}
+  return -x / 2.0 * GetExactValue(x, order + 1.0);
+}
+
+void BesselJRatioTable::Clear()
+{
+  m_Order = NA_REAL;
+  m_Tolerance = NA_REAL;
+  m_Values.clear();
+  m_ScaledDerivatives.clear();
+  m_HankelCoefficients.clear();
+}
+
+void BesselJRatioTable::Build(const double order, const double tolerance)
+{
+  m_Order = order;
+  m_Tolerance = std::max(tolerance, 10.0 * std::numeric_limits<double>::epsilon());
+
+  // Coefficients a_k(nu) of the Hankel expansion, with mu = 4 nu^2:
+  // a_k = a_{k-1} (mu - (2k - 1)^2) / (8k). The last one only serves the
+  // error estimate.
+  double muValue = 4.0 * m_Order * m_Order;
+  m_HankelCoefficients.resize(m_NumberOfHankelTerms + 1);
+  m_HankelCoefficients[0] = 1.0;
+  for (unsigned int k = 1;k <= m_NumberOfHankelTerms;++k)
+  {
+    double oddValue = 2.0 * (double)k - 1.0;
+    m_HankelCoefficients[k] = m_HankelCoefficients[k - 1] * (muValue - oddValue * oddValue) / (8.0 * (double)k);
+  }
+
+  m_AsymptoticFactor = std::pow(2.0, m_Order) * std::sqrt(2.0 / M_PI);
+
+  // The asymptotic error decreases with x; below the minimal threshold, the
+  // expansion suffers from cancellation for half-integer orders.
+  m_AsymptoticThreshold = m_MinimalAsymptoticThreshold;
+  while (this->GetAsymptoticError(m_AsymptoticThreshold) > m_Tolerance)
+    m_AsymptoticThreshold *= 1.1;
+
+  // All derivatives of the ratio are bounded by its value at 0, that is
+  // 1 / Gamma(1 + nu), so that the cubic Hermite interpolation error is
+  // bounded by step^4 / (384 Gamma(1 + nu)).
+  m_Step = std::pow(384.0 * m_Tolerance * boost::math::tgamma(1.0 + m_Order), 0.25);
+  unsigned int numNodes = (unsigned int)std::ceil(m_AsymptoticThreshold / m_Step) + 2;
+  m_InverseStep = 1.0 / m_Step;
+
+  m_Values.resize(numNodes);
+  m_ScaledDerivatives.resize(numNodes);
+
+  for (unsigned int i = 0;i < numNodes;++i)
+  {
+    double x = (double)i * m_Step;
+    m_Values[i] = GetExactValue(x, m_Order);
+    m_ScaledDerivatives[i] = m_Step * GetExactDerivative(x, m_Order);
+  }
+}
+
+double BesselJRatioTable::Evaluate(const double x) const
+{
+  if (x >= m_AsymptoticThreshold)
+    return this->GetAsymptoticValue(x);
+
+  double workPosition = x * m_InverseStep;
+  unsigned int pos = (unsigned int)workPosition;
+  double t = workPosition - (double)pos;
+  double t2 = t * t;
+  double t3 = t2 * t;
+
+  double resVal = (2.0 * t3 - 3.0 * t2 + 1.0) * m_Values[pos];
+  resVal += (t3 - 2.0 * t2 + t) * m_ScaledDerivatives[pos];
+  resVal += (3.0 * t2 - 2.0 * t3) * m_Values[pos + 1];
+  resVal += (t3 - t2) * m_ScaledDerivatives[pos + 1];
+
+  return resVal;
+}
+
+double BesselJRatioTable::EvaluateDerivative(const double x) const
+{
+  if (x >= m_AsymptoticThreshold)
+  {
+    double resVal = 0.0;
+    this->GetAsymptoticValue(x, &resVal);
+    return resVal;
+  }
+
+  double workPosition = x * m_InverseStep;
+  unsigned int pos = (unsigned int)workPosition;
+  double t = workPosition - (double)pos;
+  double t2 = t * t;
+
+  double resVal = (6.0 * t2 - 6.0 * t) * m_Values[pos];
+  resVal += (3.0 * t2 - 4.0 * t + 1.0) * m_ScaledDerivatives[pos];
+  resVal += (6.0 * t - 6.0 * t2) * m_Values[pos + 1];
+  resVal += (3.0 * t2 - 2.0 * t) * m_ScaledDerivatives[pos + 1];
+
+  return resVal * m_InverseStep;
+}
+
+double BesselJRatioTable::GetAsymptoticValue(const double x, double *derivative) const
+{
+  // J_nu(x) ~ sqrt(2 / (pi x)) (P(x) cos(chi) - Q(x) sin(chi)) with
+  // chi = x - nu pi / 2 - pi / 4
+  double inverseValue = 1.0 / x;
+  double powerValue = 1.0;
+  double pValue = 0.0, qValue = 0.0;
+  double pDerivative = 0.0, qDerivative = 0.0;
+
+  for (unsigned int k = 0;k < m_NumberOfHankelTerms;++k)
+  {
+    double signValue = ((k / 2) % 2 == 0) ? 1.0 : -1.0;
+    double termValue = signValue * m_HankelCoefficients[k] * powerValue;
+    double termDerivative = -(double)k * termValue * inverseValue;
+    if (k % 2 == 0)
+    {
+      pValue += termValue;
+      pDerivative += termDerivative;
+    }
+    else
+    {
+      qValue += termValue;
+      qDerivative += termDerivative;
+    }
+    powerValue *= inverseValue;
+  }
+
+  double chiValue = x - m_Order * M_PI / 2.0 - M_PI / 4.0;
+  double cosValue = std::cos(chiValue);
+  double sinValue = std::sin(chiValue);
+  double resVal = pValue * cosValue - qValue * sinValue;
+  double scaleValue = m_AsymptoticFactor / std::pow(x, 0.5 + m_Order);
+
+  if (derivative)
+  {
+    double workValue = (pDerivative - qValue) * cosValue - (qDerivative + pValue) * sinValue;
+    *derivative = scaleValue * (workValue - (0.5 + m_Order) * inverseValue * resVal);
+  }
+
+  return scaleValue * resVal;
+}
+
+double BesselJRatioTable::GetAsymptoticError(const double x) const
+{
+  double resVal = std::abs(m_HankelCoefficients[m_NumberOfHankelTerms]);
+  resVal /= std::pow(x, (double)m_NumberOfHankelTerms);
+  return m_AsymptoticFactor * resVal / std::pow(x, 0.5 + m_Order);
+}
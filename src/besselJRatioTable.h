@@ -0,0 +1,52 @@
+#pragma once
+
+#include <RcppEnsmallen.h>
+
+//! Lookup table for the ratio J_nu(x) / (x / 2)^nu which enters the Bessel
+//! kernels. The ratio is tabulated on a uniform grid with its derivative and
+//! evaluated by cubic Hermite interpolation up to a threshold beyond which the
+//! Hankel asymptotic expansion is used. Both the grid step and the threshold
+//! are chosen from the requested absolute accuracy. The derivative is obtained
+//! by differentiating the interpolant or the expansion.
+class BesselJRatioTable
+{
+public:
+  BesselJRatioTable()
+  {
+    m_Order = NA_REAL;
+    m_Tolerance = NA_REAL;
+    m_Step = 0.0;
+    m_InverseStep = 0.0;
+    m_AsymptoticThreshold = 0.0;
+    m_AsymptoticFactor = 0.0;
+  }
+
+  ~BesselJRatioTable() {}
+
+  void Build(const double order, const double tolerance);
+  bool IsBuilt() const {return !m_Values.empty();}
+  void Clear();
+  double Evaluate(const double x) const;
+  double EvaluateDerivative(const double x) const;
+  double GetOrder() const {return m_Order;}
+  double GetTolerance() const {return m_Tolerance;}
+  double GetAsymptoticThreshold() const {return m_AsymptoticThreshold;}
+  unsigned int GetNumberOfNodes() const {return m_Values.size();}
+
+  //! Reference value computed with boost::math::cyl_bessel_j()
+  static double GetExactValue(const double x, const double order);
+  static double GetExactDerivative(const double x, const double order);
+
+private:
+  double GetAsymptoticValue(const double x, double *derivative = NULL) const;
+  double GetAsymptoticError(const double x) const;
+
+  double m_Order, m_Tolerance;
+  double m_Step, m_InverseStep;
+  double m_AsymptoticThreshold, m_AsymptoticFactor;
+  std::vector<double> m_Values, m_ScaledDerivatives;
+  std::vector<double> m_HankelCoefficients;
+
+  static const unsigned int m_NumberOfHankelTerms;
+  static const double m_MinimalAsymptoticThreshold;
+};
@@ -1,17 +1,204 @@
 #include "besselLogLikelihood.h"
 #include <boost/math/special_functions/gamma.hpp>
 
-double BesselLogLikelihood::GetFourierKernel(const double radius, const double amplitude, const double alpha, const unsigned int dimension, const bool cross)
+double BesselLogLikelihood::GetFourierKernel(const double radius, const double alpha, const unsigned int dimension, const bool cross, double &derivative)
 {
   // if cross is true, alpha is its inverse
+  // The kernel is an indicator function so its derivative w.r.t. alpha
+  // vanishes almost everywhere; the jump at the support radius is accounted
+  // for in GetAnalyticIntegral().
   double workValue = std::sqrt(2.0 / (double)dimension) * M_PI * radius;
   bool inSupport = (cross) ? (workValue < alpha) : (alpha * workValue < 1.0);
-  return (inSupport) ? amplitude : 0.0;
+  derivative = 0.0;
+  return (inSupport) ? 1.0 : 0.0;
 }
 
-BesselLogLikelihood::KFunctionType BesselLogLikelihood::GetKFunction()
+void BesselLogLikelihood::EvaluateLEntries(
+    const double *sqDistances,
+    const unsigned int n,
+    const unsigned int labelPair,
+    double *values,
+    double *workValues)
 {
-  return this->GetFourierKernel;
+  double firstAmplitude = this->GetFirstAmplitude();
+  double secondAmplitude = this->GetSecondAmplitude();
+  double crossAmplitude = this->GetCrossAmplitude();
+  double crossFactor = crossAmplitude / ((1.0 - firstAmplitude) * (1.0 - secondAmplitude) - crossAmplitude * crossAmplitude);
+
+  if (labelPair == 1)
+  {
+    this->EvaluateSpatialKernels(sqDistances, n, this->GetInverseCrossAlpha(), true, values);
+    for (unsigned int k = 0;k < n;++k)
+      values[k] *= crossFactor;
+    return;
+  }
+
+  double amplitude = (labelPair == 0) ? firstAmplitude : secondAmplitude;
+  double alpha = (labelPair == 0) ? this->GetFirstAlpha() : this->GetSecondAlpha();
+  double denomValue = 1.0 - amplitude;
+  this->EvaluateSpatialKernels(sqDistances, n, this->GetInverseCrossAlpha(), true, workValues);
+  this->EvaluateSpatialKernels(sqDistances, n, alpha, false, values);
+
+  for (unsigned int k = 0;k < n;++k)
+    values[k] = (crossAmplitude * (workValues[k] * crossFactor) + amplitude * values[k]) / denomValue;
+}
+
+void BesselLogLikelihood::EvaluateLDerivativeEntries(
+    const double *sqDistances,
+    const unsigned int n,
+    const unsigned int labelPair,
+    double *derivatives,
+    double *workValues)
+{
+  double firstAmplitude = this->GetFirstAmplitude();
+  double secondAmplitude = this->GetSecondAmplitude();
+  double crossAmplitude = this->GetCrossAmplitude();
+  double detValue = (1.0 - firstAmplitude) * (1.0 - secondAmplitude) - crossAmplitude * crossAmplitude;
+  double *crossKernels = workValues;
+  double *crossKernelDerivatives = workValues + n;
+  this->EvaluateSpatialKernels(sqDistances, n, this->GetInverseCrossAlpha(), true, crossKernels);
+  this->EvaluateSpatialKernelDerivatives(sqDistances, n, this->GetInverseCrossAlpha(), true, crossKernelDerivatives);
+
+  for (unsigned int j = 0;j < n;++j)
+  {
+    double *entryDerivatives = derivatives + 6 * j;
+    double l12Value = crossKernels[j] * crossAmplitude / detValue;
+    double workValue = l12Value / detValue;
+
+    entryDerivatives[0] = workValue * (1.0 - secondAmplitude);
+    entryDerivatives[1] = 0.0;
+    entryDerivatives[2] = workValue * (1.0 - firstAmplitude);
+    entryDerivatives[3] = 0.0;
+    entryDerivatives[4] = crossKernels[j] * (1.0 / detValue + 2.0 * crossAmplitude * crossAmplitude / (detValue * detValue));
+    entryDerivatives[5] = crossKernelDerivatives[j] * crossAmplitude / detValue;
+  }
+
+  if (labelPair == 1)
+    return;
+
+  // L = (k12 L12 + k C) / (1 - k) for same-label pairs
+  bool firstLabel = (labelPair == 0);
+  double amplitude = (firstLabel) ? firstAmplitude : secondAmplitude;
+  double alpha = (firstLabel) ? this->GetFirstAlpha() : this->GetSecondAlpha();
+  unsigned int amplitudeIndex = (firstLabel) ? 0 : 2;
+  double denomValue = 1.0 - amplitude;
+  double *kernelValues = workValues + 2 * n;
+  double *kernelDerivatives = workValues + 3 * n;
+  this->EvaluateSpatialKernels(sqDistances, n, alpha, false, kernelValues);
+  this->EvaluateSpatialKernelDerivatives(sqDistances, n, alpha, false, kernelDerivatives);
+
+  for (unsigned int j = 0;j < n;++j)
+  {
+    double *entryDerivatives = derivatives + 6 * j;
+    double l12Value = crossKernels[j] * crossAmplitude / detValue;
+    double lValue = (crossAmplitude * l12Value + amplitude * kernelValues[j]) / denomValue;
+
+    for (unsigned int k = 0;k < 6;++k)
+      entryDerivatives[k] *= crossAmplitude / denomValue;
+
+    entryDerivatives[4] += l12Value / denomValue;
+    entryDerivatives[amplitudeIndex] += (kernelValues[j] + lValue) / denomValue;
+    entryDerivatives[amplitudeIndex + 1] += amplitude * kernelDerivatives[j] / denomValue;
+  }
+}
+
+void BesselLogLikelihood::IntegrateSpectralDensity(double &value, arma::vec &gradient)
+{
+  this->IntegrateFourierKernel<BesselLogLikelihood>(value, gradient);
+}
+
+bool BesselLogLikelihood::GetAnalyticIntegral(double &value, arma::vec &gradient)
+{
+  // The Fourier kernels are constant on balls so that the integrand
+  // log((1 - K1) (1 - K2) - K12^2) is piecewise constant in the radius with
+  // breakpoints at the three support radii. Each piece is integrated over a
+  // shell of the d-dimensional domain.
+  unsigned int dimension = this->GetDomainDimension();
+  double ballVolume = this->GetUnitBallVolume();
+  double workValue = std::sqrt((double)dimension / 2.0) / M_PI;
+  double radii[3] = {
+    workValue / this->GetFirstAlpha(),
+    workValue * this->GetInverseCrossAlpha(),
+    workValue / this->GetSecondAlpha()
+  };
+  double amplitudes[3] = {
+    this->GetFirstAmplitude(),
+    this->GetCrossAmplitude(),
+    this->GetSecondAmplitude()
+  };
+
+  unsigned int sortedIndices[3] = {0, 1, 2};
+  std::sort(sortedIndices, sortedIndices + 3, [&radii](const unsigned int i, const unsigned int j){return radii[i] < radii[j];});
+
+  // Integrand value when only the given kernels are non zero
+  auto getLogValue = [&amplitudes](const bool isActive[3]){
+    double k1 = (isActive[0]) ? amplitudes[0] : 0.0;
+    double k12 = (isActive[1]) ? amplitudes[1] : 0.0;
+    double k2 = (isActive[2]) ? amplitudes[2] : 0.0;
+    return std::log((1.0 - k1) * (1.0 - k2) - k12 * k12);
+  };
+
+  value = 0.0;
+  gradient.set_size(6);
+  gradient.fill(0.0);
+  double innerRadius = 0.0;
+
+  for (unsigned int i = 0;i < 3;++i)
+  {
+    double outerRadius = radii[sortedIndices[i]];
+    double k1 = (radii[0] >= outerRadius) ? amplitudes[0] : 0.0;
+    double k12 = (radii[1] >= outerRadius) ? amplitudes[1] : 0.0;
+    double k2 = (radii[2] >= outerRadius) ? amplitudes[2] : 0.0;
+    double detValue = (1.0 - k1) * (1.0 - k2) - k12 * k12;
+
+    if (!(detValue > 0.0))
+      return false;
+
+    // Volume omega_d (R^d - r^d) of the shell of the current piece
+    double volume = ballVolume * (std::pow(outerRadius, (double)dimension) - std::pow(innerRadius, (double)dimension));
+    value += std::log(detValue) * volume;
+
+    if (k1 > 0.0)
+      gradient[0] -= (1.0 - k2) / detValue * volume;
+    if (k2 > 0.0)
+      gradient[2] -= (1.0 - k1) / detValue * volume;
+    if (k12 > 0.0)
+      gradient[4] -= 2.0 * k12 / detValue * volume;
+
+    innerRadius = outerRadius;
+  }
+
+  // Moving a breakpoint changes the integral by the jump of the integrand
+  // across it times the area d omega_d r^(d - 1) of the sphere. When several
+  // radii coincide, which is the case at the initial point, the jump depends
+  // on the direction of the move and the two one-sided jumps are averaged.
+  for (unsigned int i = 0;i < 3;++i)
+  {
+    double radius = radii[i];
+    bool outerActive[3], innerActive[3];
+    for (unsigned int j = 0;j < 3;++j)
+    {
+      outerActive[j] = (radii[j] > radius);
+      innerActive[j] = (radii[j] >= radius);
+    }
+
+    double jumpValue = -getLogValue(outerActive);
+    outerActive[i] = true;
+    jumpValue += getLogValue(outerActive);
+    jumpValue += getLogValue(innerActive);
+    innerActive[i] = false;
+    jumpValue -= getLogValue(innerActive);
+    jumpValue *= 0.5 * (double)dimension * ballVolume * std::pow(radius, (double)dimension - 1.0);
+
+    if (i == 0)
+      gradient[1] = -jumpValue * radius / this->GetFirstAlpha();
+    else if (i == 1)
+      gradient[5] = jumpValue * radius / this->GetInverseCrossAlpha();
+    else
+      gradient[3] = -jumpValue * radius / this->GetSecondAlpha();
+  }
+
+  return true;
 }
 
 double BesselLogLikelihood::GetCrossAlphaLowerBound()
@@ -19,39 +206,85 @@ double BesselLogLikelihood::GetCrossAlphaLowerBound()
   return std::max(this->GetFirstAlpha(), this->GetSecondAlpha());
 }
 
-double BesselLogLikelihood::EvaluateLFunction(
-    const double sqDist,
-    const double amplitude,
-    const double amplitude12,
-    const double alpha,
-    const double l12Value,
-    const unsigned int dimension)
+void BesselLogLikelihood::GetCrossAlphaLowerBoundDerivatives(double &firstDerivative, double &secondDerivative)
 {
-  double denomValue = 1.0 - amplitude;
-  double firstTerm = std::pow((double)dimension / (2.0 * M_PI * alpha * alpha), (double)dimension / 2.0);
-  double secondTerm = this->GetBesselJRatio(sqDist, alpha, dimension);
-  return (amplitude12 * l12Value + amplitude * firstTerm * secondTerm) / denomValue;
+  // The maximum is not differentiable when both alphas are equal, which is
+  // the case at the initial point; the symmetric subgradient is used then.
+  double firstAlpha = this->GetFirstAlpha();
+  double secondAlpha = this->GetSecondAlpha();
+
+  if (firstAlpha > secondAlpha)
+    firstDerivative = 1.0;
+  else if (firstAlpha < secondAlpha)
+    firstDerivative = 0.0;
+  else
+    firstDerivative = 0.5;
+
+  secondDerivative = 1.0 - firstDerivative;
 }
 
-double BesselLogLikelihood::EvaluateL12Function(
-    const double sqDist,
-    const double amplitude1,
-    const double amplitude2,
-    const double amplitude12,
-    const double alpha12inv,
-    const unsigned int dimension)
+template <unsigned int TDimension>
+double BesselLogLikelihood::EvaluateKernel(const double sqDist, const double alpha, const bool cross)
 {
-  double firstTerm = std::pow((double)dimension * alpha12inv * alpha12inv / (2.0 * M_PI), (double)dimension / 2.0);
-  double secondTerm = amplitude12 / ((1.0 - amplitude1) * (1.0 - amplitude2) - amplitude12 * amplitude12);
-  double thirdTerm = this->GetBesselJRatio(sqDist, alpha12inv, dimension, true);
-  return firstTerm * secondTerm * thirdTerm;
+  // if cross is true, alpha is its inverse
+  double workValue = (cross) ? alpha * alpha : 1.0 / (alpha * alpha);
+  double firstTerm = DimensionTraits<TDimension>::GetHalfPower((double)TDimension * workValue / (2.0 * M_PI));
+  double secondTerm = this->GetBesselJRatio<TDimension>(sqDist, alpha, cross);
+  return firstTerm * secondTerm;
+}
+
+template <unsigned int TDimension>
+double BesselLogLikelihood::EvaluateKernelDerivative(const double sqDist, const double alpha, const bool cross)
+{
+  double workValue = (cross) ? alpha * alpha : 1.0 / (alpha * alpha);
+  double firstTerm = DimensionTraits<TDimension>::GetHalfPower((double)TDimension * workValue / (2.0 * M_PI));
+  double secondTerm = this->GetBesselJRatio<TDimension>(sqDist, alpha, cross);
+  double firstDerivative = (cross) ? (double)TDimension / alpha : -(double)TDimension / alpha;
+  double secondDerivative = this->GetBesselJRatioDerivative<TDimension>(sqDist, alpha, cross);
+  return firstTerm * (firstDerivative * secondTerm + secondDerivative);
+}
+
+double BesselLogLikelihood::EvaluateGenericKernel(const double sqDist, const double alpha, const bool cross)
+{
+  // if cross is true, alpha is its inverse
+  unsigned int dimension = this->GetDomainDimension();
+  double workValue = (cross) ? alpha * alpha : 1.0 / (alpha * alpha);
+  double firstTerm = std::pow((double)dimension * workValue / (2.0 * M_PI), (double)dimension / 2.0);
+  double secondTerm = this->GetBesselJRatio(sqDist, alpha, cross);
+  return firstTerm * secondTerm;
+}
+
+double BesselLogLikelihood::EvaluateGenericKernelDerivative(const double sqDist, const double alpha, const bool cross)
+{
+  // The first term is proportional to alpha^(-d), or to its inverse to the
+  // power d if cross is true
+  unsigned int dimension = this->GetDomainDimension();
+  double workValue = (cross) ? alpha * alpha : 1.0 / (alpha * alpha);
+  double firstTerm = std::pow((double)dimension * workValue / (2.0 * M_PI), (double)dimension / 2.0);
+  double secondTerm = this->GetBesselJRatio(sqDist, alpha, cross);
+  double firstDerivative = (cross) ? (double)dimension / alpha : -(double)dimension / alpha;
+  double secondDerivative = this->GetBesselJRatioDerivative(sqDist, alpha, cross);
+  return firstTerm * (firstDerivative * secondTerm + secondDerivative);
+}
+
+// Gamma(1 + d / 2) without boost in the dimensions with specialized kernels
+static double GetHalfDimensionGamma(const unsigned int dimension)
+{
+  if (dimension == 1)
+    return DimensionTraits<1>::m_GammaValue;
+  if (dimension == 2)
+    return DimensionTraits<2>::m_GammaValue;
+  if (dimension == 3)
+    return DimensionTraits<3>::m_GammaValue;
+
+  return boost::math::tgamma(1.0 + (double)dimension / 2.0);
 }
 
 double BesselLogLikelihood::RetrieveIntensityFromParameters(const double amplitude, const double alpha, const unsigned int dimension)
 {
   double order = (double)dimension / 2.0;
   double inPowerValue = M_PI * alpha * alpha / order;
-  double denomValue = std::pow(inPowerValue, order) * boost::math::tgamma(1.0 + order);
+  double denomValue = std::pow(inPowerValue, order) * GetHalfDimensionGamma(dimension);
   return amplitude / denomValue;
 }
 
@@ -61,12 +294,12 @@ double BesselLogLikelihood::RetrieveAlphaFromParameters(const double amplitude,
   // if (intensity < lim)
   //   return std::sqrt(std::numeric_limits<double>::epsilon());
   double order = (double)dimension / 2.0;
-  double gammaValue = boost::math::tgamma(1.0 + order);
+  double gammaValue = GetHalfDimensionGamma(dimension);
   return std::pow(amplitude / (intensity * gammaValue), 1.0 / (2.0 * order)) * std::sqrt(order / M_PI);
 }
 
 double BesselLogLikelihood::RetrieveAmplitudeFromParameters(const double intensity, const double alpha, const unsigned int dimension)
 {
   double order = (double)dimension / 2.0;
-  return intensity * std::pow(M_PI * alpha * alpha / order, order) * boost::math::tgamma(1.0 + order);
+  return intensity * std::pow(M_PI * alpha * alpha / order, order) * GetHalfDimensionGamma(dimension);
 }
@@ -1,36 +1,55 @@
-#include "baseLogLikelihood.h"
+#pragma once
 
-class BesselLogLikelihood : public BaseLogLikelihood
+#include "kernelLogLikelihood.h"
+
+class BesselLogLikelihood : public KernelLogLikelihood<BesselLogLikelihood>
 {
 public:
+  static double GetFourierKernel(
+      const double radius,
+      const double alpha,
+      const unsigned int dimension,
+      const bool cross,
+      double &derivative
+  );
+
   double RetrieveIntensityFromParameters(const double amplitude, const double alpha, const unsigned int dimension);
   double RetrieveAlphaFromParameters(const double amplitude, const double intensity, const unsigned int dimension);
   double RetrieveAmplitudeFromParameters(const double intensity, const double alpha, const unsigned int dimension);
 
 private:
-  double EvaluateLFunction(
-      const double sqDist,
-      const double amplitude,
-      const double amplitude12,
-      const double alpha,
-      const double l12Value,
-      const unsigned int dimension
-  );
-  double EvaluateL12Function(
-      const double sqDist,
-      const double amplitude1,
-      const double amplitude2,
-      const double amplitude12,
-      const double alpha12inv,
-      const unsigned int dimension
-  );
+  friend class KernelLogLikelihood<BesselLogLikelihood>;
+
+  template <unsigned int TDimension>
+  double EvaluateKernel(const double sqDist, const double alpha, const bool cross);
+  template <unsigned int TDimension>
+  double EvaluateKernelDerivative(const double sqDist, const double alpha, const bool cross);
+
+  //! Kernels for any dimension
+  double EvaluateGenericKernel(const double sqDist, const double alpha, const bool cross);
+  double EvaluateGenericKernelDerivative(const double sqDist, const double alpha, const bool cross);
+
+  //! L = K (I - K)^-1 in closed form. The Fourier kernels are indicators
+  //! whose supports are nested, the cross one being the smallest, so that
+  //! L12 = k12 C12 / D and L = (k12 L12 + k C) / (1 - k) for same-label
+  //! pairs, with C the kernels of unit amplitude and
+  //! D = (1 - k1) (1 - k2) - k12^2.
+  void EvaluateLEntries(
+      const double *sqDistances,
+      const unsigned int n,
+      const unsigned int labelPair,
+      double *values,
+      double *workValues);
+  void EvaluateLDerivativeEntries(
+      const double *sqDistances,
+      const unsigned int n,
+      const unsigned int labelPair,
+      double *derivatives,
+      double *workValues);
+  void UpdateLFunctions() {}
+
   double GetCrossAlphaLowerBound();
-  static double GetFourierKernel(
-      const double radius,
-      const double amplitude,
-      const double alpha,
-      const unsigned int dimension,
-      const bool cross
-  );
-  KFunctionType GetKFunction();
+  void GetCrossAlphaLowerBoundDerivatives(double &firstDerivative, double &secondDerivative);
+  bool GetAnalyticIntegral(double &value, arma::vec &gradient);
+  void IntegrateSpectralDensity(double &value, arma::vec &gradient);
 };
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <RcppEnsmallen.h>
+
+//! Wrapper exposing a box-constrained objective function as an unconstrained
+//! one to the ensmallen optimizers, such as L-BFGS, through the logistic
+//! transform x = lb + (ub - lb) / (1 + exp(-y)). The wrapped function must
+//! provide Evaluate() and EvaluateWithGradient().
+template <class TFunction>
+class BoxConstrainedFunction
+{
+public:
+  BoxConstrainedFunction(TFunction &function, const arma::vec &lowerBounds, const arma::vec &upperBounds)
+    : m_Function(function), m_LowerBounds(lowerBounds), m_UpperBounds(upperBounds) {}
+  ~BoxConstrainedFunction() {}
+
+  arma::mat GetConstrainedPoint(const arma::mat &y)
+  {
+    arma::mat x(y.n_rows, y.n_cols);
+
+    for (unsigned int i = 0;i < y.n_elem;++i)
+      x[i] = m_LowerBounds[i] + (m_UpperBounds[i] - m_LowerBounds[i]) / (1.0 + std::exp(-y[i]));
+
+    return x;
+  }
+
+  arma::mat GetUnconstrainedPoint(const arma::mat &x)
+  {
+    arma::mat y(x.n_rows, x.n_cols);
+
+    for (unsigned int i = 0;i < x.n_elem;++i)
+    {
+      // Keep away from the bounds where the transform is infinite
+      double rangeValue = m_UpperBounds[i] - m_LowerBounds[i];
+      double workValue = (x[i] - m_LowerBounds[i]) / rangeValue;
+      workValue = std::min(std::max(workValue, m_Epsilon), 1.0 - m_Epsilon);
+      y[i] = std::log(workValue / (1.0 - workValue));
+    }
+
+    return y;
+  }
+
+  double Evaluate(const arma::mat &y)
+  {
+    return m_Function.Evaluate(this->GetConstrainedPoint(y));
+  }
+
+  void Gradient(const arma::mat &y, arma::mat &g)
+  {
+    this->EvaluateWithGradient(y, g);
+  }
+
+  double EvaluateWithGradient(const arma::mat &y, arma::mat &g)
+  {
+    arma::mat x = this->GetConstrainedPoint(y);
+    double resVal = m_Function.EvaluateWithGradient(x, g);
+
+    // dx / dy = (x - lb) (ub - x) / (ub - lb)
+    for (unsigned int i = 0;i < y.n_elem;++i)
+      g[i] *= (x[i] - m_LowerBounds[i]) * (m_UpperBounds[i] - x[i]) / (m_UpperBounds[i] - m_LowerBounds[i]);
+
+    return resVal;
+  }
+
+private:
+  TFunction &m_Function;
+  arma::vec m_LowerBounds, m_UpperBounds;
+
+  static constexpr double m_Epsilon = 1.0e-8;
+};
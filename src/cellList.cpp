@@ -0,0 +1,98 @@
+#include "cellList.h"
+#include <stdexcept>
+
+void CellList::SetDomain(const arma::vec &lb, const arma::vec &ub)
+{
+  m_LowerBounds = lb;
+  m_UpperBounds = ub;
+}
+
+void CellList::Build(const arma::mat &points, const double maximalDistance)
+{
+  unsigned int dimension = m_LowerBounds.n_elem;
+  unsigned int numPoints = points.n_rows;
+
+  if (points.n_cols != dimension)
+    throw std::invalid_argument("The points should have as many coordinates as the domain bounds.");
+
+  m_MaximalDistance = maximalDistance;
+  m_CellCounts.resize(dimension);
+  m_CellLengths.resize(dimension);
+  m_NumberOfCells = 1;
+
+  // Cells are not refined beyond about one point per cell on average.
+  double maximalCount = std::max(std::pow((double)numPoints, 1.0 / (double)dimension), 1.0);
+
+  for (unsigned int l = 0;l < dimension;++l)
+  {
+    double boxLength = m_UpperBounds[l] - m_LowerBounds[l];
+    double workCount = std::floor(boxLength / maximalDistance);
+    m_CellCounts[l] = (int)std::max(std::min(workCount, maximalCount), 1.0);
+    m_CellLengths[l] = boxLength / (double)m_CellCounts[l];
+    m_NumberOfCells *= m_CellCounts[l];
+  }
+
+  // Counting sort of the points by cell
+  std::vector<unsigned int> cellIndices(numPoints);
+  m_CellStarts.assign(m_NumberOfCells + 1, 0);
+
+  for (unsigned int i = 0;i < numPoints;++i)
+  {
+    unsigned int workIndex = 0;
+    for (unsigned int l = dimension;l > 0;--l)
+    {
+      int workCoordinate = (int)std::floor((points(i, l - 1) - m_LowerBounds[l - 1]) / m_CellLengths[l - 1]);
+      workCoordinate = std::min(std::max(workCoordinate, 0), m_CellCounts[l - 1] - 1);
+      workIndex = workIndex * m_CellCounts[l - 1] + workCoordinate;
+    }
+
+    cellIndices[i] = workIndex;
+    ++m_CellStarts[workIndex + 1];
+  }
+
+  for (unsigned int c = 0;c < m_NumberOfCells;++c)
+    m_CellStarts[c + 1] += m_CellStarts[c];
+
+  std::vector<unsigned int> workPositions(m_CellStarts.begin(), m_CellStarts.end() - 1);
+  m_SortedPoints.resize(numPoints);
+
+  for (unsigned int i = 0;i < numPoints;++i)
+    m_SortedPoints[workPositions[cellIndices[i]]++] = i;
+}
+
+void CellList::GetOffsetRange(const int cellCoordinate, const unsigned int axis, int &firstOffset, int &lastOffset) const
+{
+  int numCells = m_CellCounts[axis];
+
+  if (!m_UsePeriodicDomain)
+  {
+    firstOffset = (cellCoordinate > 0) ? -1 : 0;
+    lastOffset = (cellCoordinate + 1 < numCells) ? 1 : 0;
+    return;
+  }
+
+  // With 1 or 2 cells along the axis, the offsets -1 and 1 would reach the
+  // same cell.
+  firstOffset = (numCells > 2) ? -1 : 0;
+  lastOffset = (numCells > 1) ? 1 : 0;
+}
+
+bool CellList::IncrementNeighbour(const std::vector<int> &cellCoordinates, std::vector<int> &neighbourOffsets) const
+{
+  int firstOffset = 0, lastOffset = 0;
+
+  for (unsigned int l = 0;l < cellCoordinates.size();++l)
+  {
+    this->GetOffsetRange(cellCoordinates[l], l, firstOffset, lastOffset);
+
+    if (neighbourOffsets[l] < lastOffset)
+    {
+      ++neighbourOffsets[l];
+      return true;
+    }
+
+    neighbourOffsets[l] = firstOffset;
+  }
+
+  return false;
+}
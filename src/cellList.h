@@ -0,0 +1,122 @@
+#pragma once
+
+#include <RcppEnsmallen.h>
+
+//! Cell list over a rectangular domain, used to find all pairs of points
+//! closer than a given distance in O(n k) operations, with k the mean number
+//! of points in the neighbouring cells, instead of O(n^2). The domain is
+//! split in cells whose sides are at least the search distance, so that
+//! close pairs lie in the same or in adjacent cells. On a periodic domain,
+//! cells on opposite faces are adjacent and distances are computed between
+//! nearest images.
+class CellList
+{
+public:
+  CellList()
+  {
+    m_NumberOfCells = 0;
+    m_MaximalDistance = 0.0;
+    m_UsePeriodicDomain = false;
+  }
+
+  ~CellList() {}
+
+  void SetDomain(const arma::vec &lb, const arma::vec &ub);
+  void SetUsePeriodicDomain(const bool x) {m_UsePeriodicDomain = x;}
+
+  //! Points are given row-wise and must lie inside the domain
+  void Build(const arma::mat &points, const double maximalDistance);
+
+  unsigned int GetNumberOfCells() const {return m_NumberOfCells;}
+
+  //! Calls function(i, j, difference) for each pair i < j of points at
+  //! distance less than the maximal one, where difference stores the
+  //! absolute differences |x_i - x_j| of their coordinates, between nearest
+  //! images on a periodic domain
+  template <class TFunction>
+  void VisitPairs(const arma::mat &points, TFunction &function) const;
+
+private:
+  //! Range of the offsets of the neighbouring cells along an axis, so that
+  //! each neighbour is listed once even if the axis has less than 3 cells
+  void GetOffsetRange(const int cellCoordinate, const unsigned int axis, int &firstOffset, int &lastOffset) const;
+
+  //! Moves to the next cell of the block of neighbours of the given one,
+  //! returning false when the block is exhausted
+  bool IncrementNeighbour(const std::vector<int> &cellCoordinates, std::vector<int> &neighbourOffsets) const;
+
+  arma::vec m_LowerBounds, m_UpperBounds;
+  double m_MaximalDistance;
+  unsigned int m_NumberOfCells;
+  bool m_UsePeriodicDomain;
+
+  //! Number of cells and their side along each axis
+  std::vector<int> m_CellCounts;
+  std::vector<double> m_CellLengths;
+
+  //! Points sorted by cell: those of cell c are m_SortedPoints[m_CellStarts[c]]
+  //! to m_SortedPoints[m_CellStarts[c + 1] - 1]
+  std::vector<unsigned int> m_CellStarts, m_SortedPoints;
+};
+
+template <class TFunction>
+void CellList::VisitPairs(const arma::mat &points, TFunction &function) const
+{
+  unsigned int dimension = m_CellCounts.size();
+  double sqMaximalDistance = m_MaximalDistance * m_MaximalDistance;
+  std::vector<int> cellCoordinates(dimension, 0), neighbourOffsets(dimension);
+  std::vector<double> difference(dimension);
+  int lastOffset = 0;
+
+  for (unsigned int c = 0;c < m_NumberOfCells;++c)
+  {
+    unsigned int workIndex = c;
+    for (unsigned int l = 0;l < dimension;++l)
+    {
+      cellCoordinates[l] = workIndex % m_CellCounts[l];
+      workIndex /= m_CellCounts[l];
+    }
+
+    for (unsigned int l = 0;l < dimension;++l)
+      this->GetOffsetRange(cellCoordinates[l], l, neighbourOffsets[l], lastOffset);
+
+    do
+    {
+      unsigned int neighbourIndex = 0;
+      for (unsigned int l = dimension;l > 0;--l)
+      {
+        int workCoordinate = cellCoordinates[l - 1] + neighbourOffsets[l - 1];
+        workCoordinate = (workCoordinate + m_CellCounts[l - 1]) % m_CellCounts[l - 1];
+        neighbourIndex = neighbourIndex * m_CellCounts[l - 1] + workCoordinate;
+      }
+
+      // Each pair of cells is visited once
+      if (neighbourIndex < c)
+        continue;
+
+      for (unsigned int a = m_CellStarts[c];a < m_CellStarts[c + 1];++a)
+      {
+        unsigned int i = m_SortedPoints[a];
+        unsigned int firstPosition = (neighbourIndex == c) ? a + 1 : m_CellStarts[neighbourIndex];
+
+        for (unsigned int b = firstPosition;b < m_CellStarts[neighbourIndex + 1];++b)
+        {
+          unsigned int j = m_SortedPoints[b];
+          double sqDist = 0.0;
+
+          for (unsigned int l = 0;l < dimension;++l)
+          {
+            difference[l] = std::abs(points(i, l) - points(j, l));
+            if (m_UsePeriodicDomain)
+              difference[l] = std::min(difference[l], m_UpperBounds[l] - m_LowerBounds[l] - difference[l]);
+            sqDist += difference[l] * difference[l];
+          }
+
+          if (sqDist < sqMaximalDistance)
+            function(std::min(i, j), std::max(i, j), difference);
+        }
+      }
+    }
+    while (this->IncrementNeighbour(cellCoordinates, neighbourOffsets));
+  }
+}
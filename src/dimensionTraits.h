@@ -0,0 +1,117 @@
+#pragma once
+
+#include "besselJRatioTable.h"
+#include <cmath>
+
+//! Ratio J_nu(x) / (x / 2)^nu for a half-integer order nu = n / 2 in closed
+//! form, through the spherical Bessel functions. Below m_SeriesThreshold the
+//! cancellations of the closed forms are avoided by the power series
+//! sum_k (-x^2 / 4)^k / (k! Gamma(nu + k + 1)).
+template <unsigned int TTwiceOrder>
+class HalfIntegerBesselJRatio
+{
+public:
+  static double Evaluate(const double x);
+
+private:
+  static double EvaluateSeries(const double x, const double firstTerm)
+  {
+    double order = (double)TTwiceOrder / 2.0;
+    double sqValue = -0.25 * x * x;
+    double termValue = firstTerm;
+    double resVal = firstTerm;
+
+    for (unsigned int k = 1;k <= m_NumberOfSeriesTerms;++k)
+    {
+      termValue *= sqValue / ((double)k * (order + (double)k));
+      resVal += termValue;
+    }
+
+    return resVal;
+  }
+
+  static constexpr double m_SeriesThreshold = 0.5;
+  static constexpr unsigned int m_NumberOfSeriesTerms = 6;
+};
+
+template <>
+inline double HalfIntegerBesselJRatio<1>::Evaluate(const double x)
+{
+  // 1 / Gamma(3 / 2) = 2 / sqrt(pi)
+  if (x < m_SeriesThreshold)
+    return EvaluateSeries(x, M_2_SQRTPI);
+
+  return M_2_SQRTPI * std::sin(x) / x;
+}
+
+template <>
+inline double HalfIntegerBesselJRatio<3>::Evaluate(const double x)
+{
+  // 1 / Gamma(5 / 2) = 4 / (3 sqrt(pi))
+  if (x < m_SeriesThreshold)
+    return EvaluateSeries(x, 2.0 * M_2_SQRTPI / 3.0);
+
+  return 2.0 * M_2_SQRTPI * (std::sin(x) - x * std::cos(x)) / (x * x * x);
+}
+
+template <>
+inline double HalfIntegerBesselJRatio<5>::Evaluate(const double x)
+{
+  // 1 / Gamma(7 / 2) = 8 / (15 sqrt(pi))
+  if (x < m_SeriesThreshold)
+    return EvaluateSeries(x, 4.0 * M_2_SQRTPI / 15.0);
+
+  double sqValue = x * x;
+  return 4.0 * M_2_SQRTPI * ((3.0 - sqValue) * std::sin(x) - 3.0 * x * std::cos(x)) / (sqValue * sqValue * x);
+}
+
+//! Constants of the kernels that only depend on the dimension d of the
+//! domain, so that the kernels specialized for d = 1, 2 and 3 evaluate no
+//! std::pow() nor boost::math::tgamma() per pair of points. The models fall
+//! back on their generic kernels in higher dimensions.
+template <unsigned int TDimension>
+class DimensionTraits;
+
+template <>
+class DimensionTraits<1>
+{
+public:
+  //! sqrt(2 d) and Gamma(1 + d / 2)
+  static constexpr double m_SqrtTwiceDimension = M_SQRT2;
+  static constexpr double m_GammaValue = 1.0 / M_2_SQRTPI;
+
+  //! x^(d / 2)
+  static double GetHalfPower(const double x) {return std::sqrt(x);}
+
+  //! J_nu(x) / (x / 2)^nu with nu = d / 2, and its derivative
+  //! -x / 2 J_(nu + 1)(x) / (x / 2)^(nu + 1)
+  static double GetBesselJRatio(const double x) {return HalfIntegerBesselJRatio<1>::Evaluate(x);}
+  static double GetBesselJRatioDerivative(const double x) {return -0.5 * x * HalfIntegerBesselJRatio<3>::Evaluate(x);}
+};
+
+template <>
+class DimensionTraits<2>
+{
+public:
+  static constexpr double m_SqrtTwiceDimension = 2.0;
+  static constexpr double m_GammaValue = 1.0;
+
+  static double GetHalfPower(const double x) {return x;}
+
+  //! Integer order without closed form, left to boost
+  static double GetBesselJRatio(const double x) {return BesselJRatioTable::GetExactValue(x, 1.0);}
+  static double GetBesselJRatioDerivative(const double x) {return BesselJRatioTable::GetExactDerivative(x, 1.0);}
+};
+
+template <>
+class DimensionTraits<3>
+{
+public:
+  static constexpr double m_SqrtTwiceDimension = 2.449489742783178098;
+  static constexpr double m_GammaValue = 1.5 / M_2_SQRTPI;
+
+  static double GetHalfPower(const double x) {return x * std::sqrt(x);}
+
+  static double GetBesselJRatio(const double x) {return HalfIntegerBesselJRatio<3>::Evaluate(x);}
+  static double GetBesselJRatioDerivative(const double x) {return -0.5 * x * HalfIntegerBesselJRatio<5>::Evaluate(x);}
+};
@@ -0,0 +1,244 @@
+#include "envelopeCholesky.h"
+#include <algorithm>
+#include <stdexcept>
+
+void EnvelopeCholesky::Analyze(const unsigned int n, const std::vector<unsigned int> &pairs)
+{
+  m_Size = n;
+  unsigned int numPairs = pairs.size() / 2;
+
+  if (n == 0)
+  {
+    m_Values.clear();
+    return;
+  }
+
+  // Adjacency lists of the pattern in compressed form
+  std::vector<unsigned int> adjacencyStarts(n + 1, 0), adjacencyIndices(2 * numPairs);
+  for (unsigned int p = 0;p < numPairs;++p)
+  {
+    ++adjacencyStarts[pairs[2 * p] + 1];
+    ++adjacencyStarts[pairs[2 * p + 1] + 1];
+  }
+
+  for (unsigned int i = 0;i < n;++i)
+    adjacencyStarts[i + 1] += adjacencyStarts[i];
+
+  std::vector<unsigned int> workPositions(adjacencyStarts.begin(), adjacencyStarts.end() - 1);
+  for (unsigned int p = 0;p < numPairs;++p)
+  {
+    adjacencyIndices[workPositions[pairs[2 * p]]++] = pairs[2 * p + 1];
+    adjacencyIndices[workPositions[pairs[2 * p + 1]]++] = pairs[2 * p];
+  }
+
+  // Cuthill-McKee ordering: breadth-first search of each connected component
+  // from a pseudo-peripheral node, visiting neighbours by increasing degree.
+  // The start node is the end of a search from a node of minimal degree.
+  std::vector<unsigned int> ordering;
+  std::vector<bool> visitedNodes(n, false);
+  ordering.reserve(n);
+
+  std::vector<unsigned int> sortedNodes(n);
+  for (unsigned int i = 0;i < n;++i)
+    sortedNodes[i] = i;
+  std::stable_sort(sortedNodes.begin(), sortedNodes.end(), [&](const unsigned int a, const unsigned int b) {
+    return adjacencyStarts[a + 1] - adjacencyStarts[a] < adjacencyStarts[b + 1] - adjacencyStarts[b];
+  });
+
+  std::vector<unsigned int> workNeighbours;
+
+  for (unsigned int s = 0;s < n;++s)
+  {
+    unsigned int startNode = sortedNodes[s];
+    if (visitedNodes[startNode])
+      continue;
+
+    for (unsigned int pass = 0;pass < 2;++pass)
+    {
+      unsigned int firstPosition = ordering.size();
+      ordering.push_back(startNode);
+      visitedNodes[startNode] = true;
+
+      for (unsigned int a = firstPosition;a < ordering.size();++a)
+      {
+        unsigned int node = ordering[a];
+        workNeighbours.assign(adjacencyIndices.begin() + adjacencyStarts[node], adjacencyIndices.begin() + adjacencyStarts[node + 1]);
+        std::stable_sort(workNeighbours.begin(), workNeighbours.end(), [&](const unsigned int b, const unsigned int c) {
+          return adjacencyStarts[b + 1] - adjacencyStarts[b] < adjacencyStarts[c + 1] - adjacencyStarts[c];
+        });
+
+        for (unsigned int b = 0;b < workNeighbours.size();++b)
+        {
+          if (visitedNodes[workNeighbours[b]])
+            continue;
+
+          visitedNodes[workNeighbours[b]] = true;
+          ordering.push_back(workNeighbours[b]);
+        }
+      }
+
+      if (pass == 1)
+        break;
+
+      // Restart from the last node reached, which is far from the first one.
+      startNode = ordering.back();
+      for (unsigned int a = firstPosition;a < ordering.size();++a)
+        visitedNodes[ordering[a]] = false;
+      ordering.resize(firstPosition);
+    }
+  }
+
+  // Reversing the ordering gives a smaller envelope.
+  m_InversePermutation.resize(n);
+  for (unsigned int k = 0;k < n;++k)
+    m_InversePermutation[ordering[n - 1 - k]] = k;
+
+  // Envelope of the permuted matrix, with non-decreasing first columns
+  m_FirstColumns.resize(n);
+  for (unsigned int i = 0;i < n;++i)
+  {
+    unsigned int k = m_InversePermutation[i];
+    unsigned int firstColumn = k;
+
+    for (unsigned int a = adjacencyStarts[i];a < adjacencyStarts[i + 1];++a)
+      firstColumn = std::min(firstColumn, m_InversePermutation[adjacencyIndices[a]]);
+
+    m_FirstColumns[k] = firstColumn;
+  }
+
+  for (unsigned int k = n - 1;k > 0;--k)
+    m_FirstColumns[k - 1] = std::min(m_FirstColumns[k - 1], m_FirstColumns[k]);
+
+  m_RowOffsets.resize(n + 1);
+  m_RowOffsets[0] = 0;
+  for (unsigned int k = 0;k < n;++k)
+    m_RowOffsets[k + 1] = m_RowOffsets[k] + (k - m_FirstColumns[k] + 1);
+
+  m_LastRows.resize(n);
+  unsigned int lastRow = 0;
+  for (unsigned int c = 0;c < n;++c)
+  {
+    lastRow = std::max(lastRow, c);
+    while (lastRow + 1 < n && m_FirstColumns[lastRow + 1] <= c)
+      ++lastRow;
+    m_LastRows[c] = lastRow;
+  }
+
+  m_Values.assign(m_RowOffsets[n], 0.0);
+}
+
+arma::uword EnvelopeCholesky::GetPosition(const unsigned int i, const unsigned int j) const
+{
+  unsigned int k = std::max(m_InversePermutation[i], m_InversePermutation[j]);
+  unsigned int c = std::min(m_InversePermutation[i], m_InversePermutation[j]);
+
+  if (c < m_FirstColumns[k])
+    throw std::out_of_range("The entry does not belong to the envelope.");
+
+  return m_RowOffsets[k] + c - m_FirstColumns[k];
+}
+
+double EnvelopeCholesky::GetDotProduct(const double *firstValues, const double *secondValues, const unsigned int n)
+{
+  // Four partial sums so that the loop does not wait on a single
+  // accumulator
+  double workSums[4] = {0.0, 0.0, 0.0, 0.0};
+  unsigned int i = 0;
+
+  for (;i + 4 <= n;i += 4)
+  {
+    workSums[0] += firstValues[i] * secondValues[i];
+    workSums[1] += firstValues[i + 1] * secondValues[i + 1];
+    workSums[2] += firstValues[i + 2] * secondValues[i + 2];
+    workSums[3] += firstValues[i + 3] * secondValues[i + 3];
+  }
+
+  for (;i < n;++i)
+    workSums[0] += firstValues[i] * secondValues[i];
+
+  return (workSums[0] + workSums[1]) + (workSums[2] + workSums[3]);
+}
+
+bool EnvelopeCholesky::Factorize()
+{
+  // Row by row: since first columns are non-decreasing, rows k and c < k
+  // overlap from f_k on.
+  for (unsigned int k = 0;k < m_Size;++k)
+  {
+    unsigned int firstColumn = m_FirstColumns[k];
+    double *rowValues = &(m_Values[m_RowOffsets[k]]);
+
+    for (unsigned int c = firstColumn;c < k;++c)
+    {
+      const double *otherValues = &(m_Values[m_RowOffsets[c]]) + (firstColumn - m_FirstColumns[c]);
+      double workValue = rowValues[c - firstColumn] - GetDotProduct(rowValues, otherValues, c - firstColumn);
+      rowValues[c - firstColumn] = workValue / otherValues[c - firstColumn];
+    }
+
+    double diagonalValue = rowValues[k - firstColumn] - GetDotProduct(rowValues, rowValues, k - firstColumn);
+
+    if (!(diagonalValue > 0.0))
+      return false;
+
+    rowValues[k - firstColumn] = std::sqrt(diagonalValue);
+  }
+
+  return true;
+}
+
+double EnvelopeCholesky::GetLogDeterminant() const
+{
+  double resVal = 0.0;
+
+  for (unsigned int k = 0;k < m_Size;++k)
+    resVal += std::log(m_Values[m_RowOffsets[k + 1] - 1]);
+
+  return 2.0 * resVal;
+}
+
+void EnvelopeCholesky::Invert()
+{
+  // Takahashi recurrence for Z = inv(G G^T), from the last column on:
+  //   Z_ji = -(1 / G_ii) sum_(k > i) G_ki Z_kj for j > i
+  //   Z_ii = 1 / G_ii^2 - (1 / G_ii) sum_(k > i) G_ki Z_ki
+  // where G_ki vanishes beyond the last row of column i, so that only entries
+  // of Z within the envelope are involved.
+  std::vector<double> factorValues, inverseValues;
+
+  for (unsigned int i = m_Size;i > 0;--i)
+  {
+    unsigned int c = i - 1;
+    unsigned int lastRow = m_LastRows[c];
+    unsigned int numRows = lastRow - c;
+    double diagonalValue = this->GetEntry(c, c);
+
+    // Column c of G below the diagonal, which is overwritten by Z
+    factorValues.resize(numRows);
+    inverseValues.resize(numRows);
+    for (unsigned int a = 0;a < numRows;++a)
+      factorValues[a] = this->GetEntry(c + 1 + a, c);
+
+    // Z_kj is stored in row j for k <= j and in row k for k > j. Both parts
+    // are accumulated along rows, which are contiguous.
+    for (unsigned int b = 0;b < numRows;++b)
+      inverseValues[b] = GetDotProduct(factorValues.data(), &(this->GetEntry(c + 1 + b, c + 1)), b + 1);
+
+    for (unsigned int a = 1;a < numRows;++a)
+    {
+      const double *rowValues = &(this->GetEntry(c + 1 + a, c + 1));
+      double factorValue = factorValues[a];
+      for (unsigned int b = 0;b < a;++b)
+        inverseValues[b] += factorValue * rowValues[b];
+    }
+
+    for (unsigned int b = 0;b < numRows;++b)
+      inverseValues[b] = -inverseValues[b] / diagonalValue;
+
+    double workValue = GetDotProduct(factorValues.data(), inverseValues.data(), numRows);
+
+    for (unsigned int b = 0;b < numRows;++b)
+      this->GetEntry(c + 1 + b, c) = inverseValues[b];
+
+    this->GetEntry(c, c) = (1.0 / diagonalValue - workValue) / diagonalValue;
+  }
+}
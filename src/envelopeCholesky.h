@@ -0,0 +1,66 @@
+#pragma once
+
+#include <RcppEnsmallen.h>
+
+//! Cholesky factorization L = G G^T of a sparse symmetric positive definite
+//! matrix stored by its envelope, i.e. from the first non-zero entry of each
+//! row to the diagonal. Rows and columns are first permuted by the reverse
+//! Cuthill-McKee ordering of the sparsity pattern, which keeps the envelope
+//! narrow when the pattern comes from pairs of close points, and the first
+//! columns are made non-decreasing so that each column of the envelope is
+//! contiguous too. There is no fill-in outside the envelope, so the factor
+//! overwrites the matrix. The entries of the inverse within the envelope,
+//! which include those of the pattern, are then obtained by the Takahashi
+//! recurrence at the cost of the factorization.
+class EnvelopeCholesky
+{
+public:
+  EnvelopeCholesky()
+  {
+    m_Size = 0;
+  }
+
+  ~EnvelopeCholesky() {}
+
+  //! Computes the ordering and the envelope of a symmetric n x n pattern
+  //! given by its off-diagonal pairs (i, j), stored consecutively
+  void Analyze(const unsigned int n, const std::vector<unsigned int> &pairs);
+
+  unsigned int GetSize() const {return m_Size;}
+  arma::uword GetNumberOfEntries() const {return m_Values.size();}
+
+  //! Position in GetValues() of the entry (i, j) of the unpermuted matrix,
+  //! which must lie in the pattern or on the diagonal
+  arma::uword GetPosition(const unsigned int i, const unsigned int j) const;
+
+  double *GetValues() {return m_Values.data();}
+  void ResetValues() {std::fill(m_Values.begin(), m_Values.end(), 0.0);}
+
+  //! Overwrites the matrix with its factor G. Returns false if the matrix is
+  //! not positive definite.
+  bool Factorize();
+
+  //! Log-determinant of the factorized matrix
+  double GetLogDeterminant() const;
+
+  //! Overwrites the factor with the entries of the inverse of the matrix
+  //! within the envelope
+  void Invert();
+
+private:
+  static double GetDotProduct(const double *firstValues, const double *secondValues, const unsigned int n);
+
+  //! Entry (k, c) of the permuted matrix for f_k <= c <= k
+  double &GetEntry(const unsigned int k, const unsigned int c) {return m_Values[m_RowOffsets[k] + c - m_FirstColumns[k]];}
+
+  unsigned int m_Size;
+
+  //! Position of each row of the unpermuted matrix in the permuted one
+  std::vector<unsigned int> m_InversePermutation;
+
+  //! First column f_k of each row of the envelope, the last row whose first
+  //! column is at most k and the start of each row in the storage
+  std::vector<unsigned int> m_FirstColumns, m_LastRows;
+  std::vector<arma::uword> m_RowOffsets;
+  std::vector<double> m_Values;
+};
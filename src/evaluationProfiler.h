@@ -0,0 +1,99 @@
+#pragma once
+
+#include <RcppEnsmallen.h>
+
+//! Counters and wall-clock timers of the phases of likelihood evaluations.
+//! Disabled by default, in which case every call reduces to a test of a flag.
+//! Phases may be nested (the assembly of the L-matrix is part of the
+//! log-determinant) but a phase must not be started again before it stops.
+class EvaluationProfiler
+{
+public:
+  enum PhaseType
+  {
+    InputsPhase = 0,
+    IntegralPhase,
+    AssemblyPhase,
+    LogDeterminantPhase,
+    NumberOfPhases
+  };
+
+  enum CounterType
+  {
+    EvaluationCounter = 0,
+    CacheHitCounter,
+    PartialCacheHitCounter,
+    IntegralCounter,
+    QuadratureNodeCounter,
+    LogDeterminantCounter,
+    CappedLFunctionCounter,
+    NumberOfCounters
+  };
+
+  EvaluationProfiler()
+  {
+    m_Enabled = false;
+    this->Reset();
+  }
+
+  ~EvaluationProfiler() {}
+
+  void SetEnabled(const bool x) {m_Enabled = x;}
+  bool IsEnabled() const {return m_Enabled;}
+
+  void Reset()
+  {
+    for (unsigned int i = 0;i < NumberOfPhases;++i)
+      m_Times[i] = 0.0;
+    for (unsigned int i = 0;i < NumberOfCounters;++i)
+      m_Counters[i] = 0.0;
+  }
+
+  void Start(const PhaseType phase)
+  {
+    if (m_Enabled)
+      m_Clocks[phase].tic();
+  }
+
+  void Stop(const PhaseType phase)
+  {
+    if (m_Enabled)
+      m_Times[phase] += m_Clocks[phase].toc();
+  }
+
+  void Increment(const CounterType counter, const double n = 1.0)
+  {
+    if (m_Enabled)
+      m_Counters[counter] += n;
+  }
+
+  double GetTime(const PhaseType phase) const {return m_Times[phase];}
+  double GetCounter(const CounterType counter) const {return m_Counters[counter];}
+
+  //! Counters and times in seconds as a named list
+  Rcpp::List GetReport() const
+  {
+    return Rcpp::List::create(
+      Rcpp::Named("enabled") = m_Enabled,
+      Rcpp::Named("evaluations") = m_Counters[EvaluationCounter],
+      Rcpp::Named("cache_hits") = m_Counters[CacheHitCounter],
+      Rcpp::Named("partial_cache_hits") = m_Counters[PartialCacheHitCounter],
+      Rcpp::Named("integrals") = m_Counters[IntegralCounter],
+      Rcpp::Named("quadrature_nodes") = m_Counters[QuadratureNodeCounter],
+      Rcpp::Named("log_determinants") = m_Counters[LogDeterminantCounter],
+      Rcpp::Named("capped_l_functions") = m_Counters[CappedLFunctionCounter],
+      Rcpp::Named("inputs_time") = m_Times[InputsPhase],
+      Rcpp::Named("integral_time") = m_Times[IntegralPhase],
+      Rcpp::Named("assembly_time") = m_Times[AssemblyPhase],
+      Rcpp::Named("log_determinant_time") = m_Times[LogDeterminantPhase]
+    );
+  }
+
+private:
+  bool m_Enabled;
+  arma::wall_clock m_Clocks[NumberOfPhases];
+  double m_Times[NumberOfPhases];
+
+  //! Stored as doubles since node counts of long fits may exceed 32 bits
+  double m_Counters[NumberOfCounters];
+};
@@ -0,0 +1,94 @@
+#include <RcppEnsmallen.h>
+#include "gaussLogLikelihood.h"
+
+// [[Rcpp::export]]
+double EvaluateGauss(
+    const arma::vec &p,
+    const arma::mat &X,
+    const arma::uvec &labels,
+    const arma::vec &lb,
+    const arma::vec &ub,
+    const double rho1 = NA_REAL,
+    const double rho2 = NA_REAL,
+    const unsigned int num_threads = 1,
+    const double sparse_tolerance = 0.0,
+    const unsigned int num_probes = 0,
+    const bool single_precision = false,
+    const unsigned int num_correction_probes = 16)
+{
+  // Construct the objective function.
+  GaussLogLikelihood logLik;
+  logLik.SetNumberOfThreads(num_threads);
+  logLik.SetSparseTolerance(sparse_tolerance);
+  logLik.SetNumberOfProbes(num_probes);
+  logLik.SetSinglePrecision(single_precision);
+  logLik.SetNumberOfCorrectionProbes(num_correction_probes);
+  logLik.SetInputs(X, labels, lb, ub);
+
+  if (arma::is_finite(rho1) & arma::is_finite(rho2))
+    logLik.SetIntensities(rho1, rho2);
+
+  arma::mat params(p.n_elem, 1);
+  for (unsigned int i = 0;i < p.n_elem;++i)
+    params[i] = p[i];
+
+  double resVal = logLik.Evaluate(params);
+  logLik.WarnCappedLFunctions();
+
+  return resVal;
+}
+
+// [[Rcpp::export]]
+SEXP CreateGaussLogLikelihood(
+    const arma::mat &X,
+    const arma::uvec &labels,
+    const arma::vec &lb,
+    const arma::vec &ub,
+    const double rho1 = NA_REAL,
+    const double rho2 = NA_REAL,
+    const unsigned int num_threads = 1,
+    const double sparse_tolerance = 0.0,
+    const unsigned int num_probes = 0,
+    const bool single_precision = false,
+    const unsigned int num_correction_probes = 16,
+    const bool profile = false)
+{
+  // Construct the objective function once so that the distances are shared
+  // by all subsequent evaluations.
+  GaussLogLikelihood *logLik = new GaussLogLikelihood;
+  Rcpp::XPtr<BaseLogLikelihood> logLikPtr(logLik, true);
+  logLik->SetNumberOfThreads(num_threads);
+  logLik->SetSparseTolerance(sparse_tolerance);
+  logLik->SetNumberOfProbes(num_probes);
+  logLik->SetSinglePrecision(single_precision);
+  logLik->SetNumberOfCorrectionProbes(num_correction_probes);
+  logLik->SetProfiling(profile);
+  logLik->SetInputs(X, labels, lb, ub);
+
+  if (arma::is_finite(rho1) & arma::is_finite(rho2))
+    logLik->SetIntensities(rho1, rho2);
+
+  return logLikPtr;
+}
+
+// [[Rcpp::export]]
+arma::mat InitializeGauss(
+    const arma::mat &X,
+    const arma::uvec &labels,
+    const arma::vec &lb,
+    const arma::vec &ub,
+    const double rho1 = NA_REAL,
+    const double rho2 = NA_REAL,
+    const double alpha1 = NA_REAL,
+    const double alpha2 = NA_REAL,
+    const bool estimate_alpha = true)
+{
+  // Construct the objective function.
+  GaussLogLikelihood logLik;
+  logLik.SetInputs(X, labels, lb, ub);
+
+  if (arma::is_finite(rho1) & arma::is_finite(rho2))
+    logLik.SetIntensities(rho1, rho2);
+
+  return logLik.GetInitialPoint();
+}
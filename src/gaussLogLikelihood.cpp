@@ -0,0 +1,90 @@
+#include "gaussLogLikelihood.h"
+
+double GaussLogLikelihood::GetFourierKernel(const double radius, const double alpha, const unsigned int dimension, const bool cross, double &derivative)
+{
+  // if cross is true, alpha is its inverse
+  double sqRadius = M_PI * M_PI * radius * radius;
+
+  if (cross)
+  {
+    double sqAlpha = alpha * alpha;
+    double resVal = std::exp(-sqRadius / sqAlpha);
+    derivative = 2.0 * sqRadius / (sqAlpha * alpha) * resVal;
+    return resVal;
+  }
+
+  double resVal = std::exp(-sqRadius * alpha * alpha);
+  derivative = -2.0 * sqRadius * alpha * resVal;
+  return resVal;
+}
+
+void GaussLogLikelihood::IntegrateSpectralDensity(double &value, arma::vec &gradient)
+{
+  this->IntegrateFourierKernel<GaussLogLikelihood>(value, gradient);
+}
+
+double GaussLogLikelihood::GetCrossAlphaLowerBound()
+{
+  double firstAlpha = this->GetFirstAlpha();
+  double secondAlpha = this->GetSecondAlpha();
+  return std::sqrt((firstAlpha * firstAlpha + secondAlpha * secondAlpha) / 2.0);
+}
+
+void GaussLogLikelihood::GetCrossAlphaLowerBoundDerivatives(double &firstDerivative, double &secondDerivative)
+{
+  double lowerBound = this->GetCrossAlphaLowerBound();
+  firstDerivative = this->GetFirstAlpha() / (2.0 * lowerBound);
+  secondDerivative = this->GetSecondAlpha() / (2.0 * lowerBound);
+}
+
+template <unsigned int TDimension>
+double GaussLogLikelihood::EvaluateKernel(const double sqDist, const double alpha, const bool cross)
+{
+  // if cross is true, alpha is its inverse
+  double sqInverseAlpha = (cross) ? alpha * alpha : 1.0 / (alpha * alpha);
+  double firstTerm = DimensionTraits<TDimension>::GetHalfPower(sqInverseAlpha / M_PI);
+  return firstTerm * std::exp(-sqDist * sqInverseAlpha);
+}
+
+template <unsigned int TDimension>
+double GaussLogLikelihood::EvaluateKernelDerivative(const double sqDist, const double alpha, const bool cross)
+{
+  double kernelValue = this->EvaluateKernel<TDimension>(sqDist, alpha, cross);
+  double sqInverseAlpha = (cross) ? alpha * alpha : 1.0 / (alpha * alpha);
+  double resVal = (double)TDimension - 2.0 * sqDist * sqInverseAlpha;
+  return ((cross) ? resVal : -resVal) * kernelValue / alpha;
+}
+
+double GaussLogLikelihood::EvaluateGenericKernel(const double sqDist, const double alpha, const bool cross)
+{
+  // if cross is true, alpha is its inverse
+  unsigned int dimension = this->GetDomainDimension();
+  double sqInverseAlpha = (cross) ? alpha * alpha : 1.0 / (alpha * alpha);
+  double firstTerm = std::pow(sqInverseAlpha / M_PI, (double)dimension / 2.0);
+  return firstTerm * std::exp(-sqDist * sqInverseAlpha);
+}
+
+double GaussLogLikelihood::EvaluateGenericKernelDerivative(const double sqDist, const double alpha, const bool cross)
+{
+  // if cross is true, alpha is its inverse
+  unsigned int dimension = this->GetDomainDimension();
+  double kernelValue = this->EvaluateGenericKernel(sqDist, alpha, cross);
+  double sqInverseAlpha = (cross) ? alpha * alpha : 1.0 / (alpha * alpha);
+  double resVal = (double)dimension - 2.0 * sqDist * sqInverseAlpha;
+  return ((cross) ? resVal : -resVal) * kernelValue / alpha;
+}
+
+double GaussLogLikelihood::RetrieveIntensityFromParameters(const double amplitude, const double alpha, const unsigned int dimension)
+{
+  return amplitude / std::pow(std::sqrt(M_PI) * alpha, (double)dimension);
+}
+
+double GaussLogLikelihood::RetrieveAlphaFromParameters(const double amplitude, const double intensity, const unsigned int dimension)
+{
+  return std::pow(amplitude / intensity, 1.0 / (double)dimension) / std::sqrt(M_PI);
+}
+
+double GaussLogLikelihood::RetrieveAmplitudeFromParameters(const double intensity, const double alpha, const unsigned int dimension)
+{
+  return intensity * std::pow(std::sqrt(M_PI) * alpha, (double)dimension);
+}
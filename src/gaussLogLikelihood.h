@@ -0,0 +1,35 @@
+#pragma once
+
+#include "kernelLogLikelihood.h"
+
+class GaussLogLikelihood : public KernelLogLikelihood<GaussLogLikelihood>
+{
+public:
+  static double GetFourierKernel(
+      const double radius,
+      const double alpha,
+      const unsigned int dimension,
+      const bool cross,
+      double &derivative
+  );
+
+  double RetrieveIntensityFromParameters(const double amplitude, const double alpha, const unsigned int dimension);
+  double RetrieveAlphaFromParameters(const double amplitude, const double intensity, const unsigned int dimension);
+  double RetrieveAmplitudeFromParameters(const double intensity, const double alpha, const unsigned int dimension);
+
+private:
+  friend class KernelLogLikelihood<GaussLogLikelihood>;
+
+  template <unsigned int TDimension>
+  double EvaluateKernel(const double sqDist, const double alpha, const bool cross);
+  template <unsigned int TDimension>
+  double EvaluateKernelDerivative(const double sqDist, const double alpha, const bool cross);
+
+  //! Kernels for any dimension
+  double EvaluateGenericKernel(const double sqDist, const double alpha, const bool cross);
+  double EvaluateGenericKernelDerivative(const double sqDist, const double alpha, const bool cross);
+
+  double GetCrossAlphaLowerBound();
+  void GetCrossAlphaLowerBoundDerivatives(double &firstDerivative, double &secondDerivative);
+  void IntegrateSpectralDensity(double &value, arma::vec &gradient);
+};
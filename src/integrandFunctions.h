@@ -1,40 +1,182 @@
 #pragma once
 
 #include <RcppEnsmallen.h>
+#include <boost/math/quadrature/gauss.hpp>
+#include <boost/math/quadrature/gauss_kronrod.hpp>
 
-class BaseIntegrand
+//! Spectral integrand evaluating, in a single pass per quadrature node, the
+//! value log det(I - K(t)) and its partial derivatives w.r.t. (k1, alpha1, k2,
+//! alpha2, k12, 1 / alpha12), all multiplied by the radial measure t^(d - 1)
+//! of the domain dimension d. The
+//! Fourier kernel is provided by TModel::GetFourierKernel(), which returns the
+//! kernel for a unit amplitude and stores its derivative w.r.t. alpha. It is
+//! called through the model so that it may depend on extra model parameters.
+template <class TModel>
+class FusedIntegrand
 {
 public:
-  typedef std::function<double(const double, const double, const double, const unsigned int, const bool)> KFunctionType;
-
-  BaseIntegrand() {}
-  ~BaseIntegrand() {}
-
-  void SetKFunction(const KFunctionType f) {m_KFunction = f;}
-  void SetFirstAlpha(const double x) {m_FirstAlpha = x;}
-  void SetInverseCrossAlpha(const double x) {m_InverseCrossAlpha = x;}
-  void SetSecondAlpha(const double x) {m_SecondAlpha = x;}
-  void SetFirstAmplitude(const double x) {m_FirstAmplitude = x;}
-  void SetCrossAmplitude(const double x) {m_CrossAmplitude = x;}
-  void SetSecondAmplitude(const double x) {m_SecondAmplitude = x;}
+  static const unsigned int NumberOfComponents = 7;
+  typedef std::array<double, NumberOfComponents> ValueType;
+
+  FusedIntegrand() {m_Model = NULL;}
+  ~FusedIntegrand() {}
+
+  void SetModel(const TModel *model) {m_Model = model;}
+  void SetFirstAlpha(const double x) {m_Alphas[0] = x;}
+  void SetInverseCrossAlpha(const double x) {m_Alphas[1] = x;}
+  void SetSecondAlpha(const double x) {m_Alphas[2] = x;}
+  void SetFirstAmplitude(const double x) {m_Amplitudes[0] = x;}
+  void SetCrossAmplitude(const double x) {m_Amplitudes[1] = x;}
+  void SetSecondAmplitude(const double x) {m_Amplitudes[2] = x;}
   void SetDomainDimension(const unsigned int d) {m_DomainDimension = d;}
 
-  double operator()(const double radius);
-  double GetDerivativeWRTFirstAlpha(const double radius);
-  double GetDerivativeWRTCrossAlpha(const double radius);
-  double GetDerivativeWRTSecondAlpha(const double radius);
-  double GetDerivativeWRTCrossIntensity(const double radius);
+  void operator()(const double radius, ValueType &values) const
+  {
+    double kernelValues[3], kernelDerivatives[3];
+
+    for (unsigned int i = 0;i < 3;++i)
+      kernelValues[i] = m_Model->GetFourierKernel(radius, m_Alphas[i], m_DomainDimension, i == 1, kernelDerivatives[i]);
+
+    double k1 = m_Amplitudes[0] * kernelValues[0];
+    double k12 = m_Amplitudes[1] * kernelValues[1];
+    double k2 = m_Amplitudes[2] * kernelValues[2];
+
+    double measureValue = 1.0;
+    if (m_DomainDimension == 2)
+      measureValue = radius;
+    else if (m_DomainDimension > 2)
+      measureValue = std::pow(radius, (double)m_DomainDimension - 1.0);
+
+    // (1 - lambda_max) (1 - lambda_min) = det(I - K)
+    double detValue = (1.0 - k1) * (1.0 - k2) - k12 * k12;
+    double derivK1 = -(1.0 - k2) / detValue * measureValue;
+    double derivK2 = -(1.0 - k1) / detValue * measureValue;
+    double derivK12 = -2.0 * k12 / detValue * measureValue;
+
+    values[0] = std::log(detValue) * measureValue;
+    values[1] = derivK1 * kernelValues[0];
+    values[2] = derivK1 * m_Amplitudes[0] * kernelDerivatives[0];
+    values[3] = derivK2 * kernelValues[2];
+    values[4] = derivK2 * m_Amplitudes[2] * kernelDerivatives[2];
+    values[5] = derivK12 * kernelValues[1];
+    values[6] = derivK12 * m_Amplitudes[1] * kernelDerivatives[1];
+  }
 
 private:
-  double m_FirstAlpha, m_InverseCrossAlpha, m_SecondAlpha;
-  double m_FirstAmplitude, m_CrossAmplitude, m_SecondAmplitude;
+  const TModel *m_Model;
+  double m_Alphas[3];
+  double m_Amplitudes[3];
   unsigned int m_DomainDimension;
+};
+
+//! Adaptive Gauss-Kronrod (30/61 points) integration over [0, inf) of all
+//! components of a vector-valued integrand at once. The half-line is mapped
+//! onto (-1, 1) as in boost::math::quadrature::gauss_kronrod and intervals
+//! are bisected until every component meets the relative tolerance.
+//! Integrate() returns the number of evaluations of the integrand.
+template <class TIntegrand>
+class FusedQuadrature
+{
+public:
+  typedef typename TIntegrand::ValueType ValueType;
+  static const unsigned int NumberOfComponents = TIntegrand::NumberOfComponents;
+
+  static unsigned int Integrate(
+      const TIntegrand &integrand,
+      ValueType &result,
+      const unsigned int maxDepth = 15,
+      const double tolerance = std::sqrt(std::numeric_limits<double>::epsilon()))
+  {
+    ValueType absTolerance;
+    absTolerance.fill(0.0);
+    unsigned int numNodes = IntegrateRecursively(integrand, -1.0, 1.0, maxDepth, tolerance, absTolerance, result);
+
+    for (unsigned int k = 0;k < NumberOfComponents;++k)
+      result[k] *= 2.0;
+
+    return numNodes;
+  }
+
+private:
+  typedef boost::math::quadrature::gauss_kronrod<double, 61> KronrodType;
+  typedef boost::math::quadrature::gauss<double, 30> GaussType;
+
+  static void EvaluateMapped(const TIntegrand &integrand, const double t, ValueType &values)
+  {
+    double z = 1.0 / (t + 1.0);
+    integrand(2.0 * z - 1.0, values);
+    for (unsigned int k = 0;k < NumberOfComponents;++k)
+      values[k] *= z * z;
+  }
+
+  static unsigned int IntegrateRecursively(
+      const TIntegrand &integrand,
+      const double a,
+      const double b,
+      const unsigned int maxLevels,
+      const double tolerance,
+      ValueType absTolerance,
+      ValueType &result)
+  {
+    const double mean = (a + b) / 2.0;
+    const double scale = (b - a) / 2.0;
+    const auto &abscissa = KronrodType::abscissa();
+    const auto &kronrodWeights = KronrodType::weights();
+    const auto &gaussWeights = GaussType::weights();
+
+    ValueType kronrodResult, gaussResult, fp, fm;
+    gaussResult.fill(0.0);
+
+    // The 30-point Gauss nodes are the odd-indexed Kronrod nodes
+    EvaluateMapped(integrand, mean, fp);
+    for (unsigned int k = 0;k < NumberOfComponents;++k)
+      kronrodResult[k] = fp[k] * kronrodWeights[0];
+
+    for (unsigned int i = 1;i < abscissa.size();++i)
+    {
+      EvaluateMapped(integrand, mean + scale * abscissa[i], fp);
+      EvaluateMapped(integrand, mean - scale * abscissa[i], fm);
+
+      for (unsigned int k = 0;k < NumberOfComponents;++k)
+      {
+        double workValue = fp[k] + fm[k];
+        kronrodResult[k] += workValue * kronrodWeights[i];
+        if (i & 1)
+          gaussResult[k] += workValue * gaussWeights[i / 2];
+      }
+    }
+
+    bool refine = false;
+
+    for (unsigned int k = 0;k < NumberOfComponents;++k)
+    {
+      result[k] = scale * kronrodResult[k];
+      double errorValue = std::max(
+        std::abs(scale * (kronrodResult[k] - gaussResult[k])),
+        std::abs(result[k]) * 2.0 * std::numeric_limits<double>::epsilon()
+      );
+      double relTolerance = std::abs(result[k] * tolerance);
+      if (absTolerance[k] == 0.0)
+        absTolerance[k] = relTolerance;
+      if (relTolerance < errorValue && absTolerance[k] < errorValue)
+        refine = true;
+    }
+
+    unsigned int numNodes = 2 * abscissa.size() - 1;
+
+    if (!maxLevels || !refine)
+      return numNodes;
+
+    ValueType rightResult;
+    for (unsigned int k = 0;k < NumberOfComponents;++k)
+      absTolerance[k] /= 2.0;
+
+    numNodes += IntegrateRecursively(integrand, a, mean, maxLevels - 1, tolerance, absTolerance, result);
+    numNodes += IntegrateRecursively(integrand, mean, b, maxLevels - 1, tolerance, absTolerance, rightResult);
 
-  void RetrieveEigenvalues(const arma::vec &kernelMatrix);
-  void Update(const double radius);
+    for (unsigned int k = 0;k < NumberOfComponents;++k)
+      result[k] += rightResult[k];
 
-  KFunctionType m_KFunction;
-  arma::vec m_Kernel;
-  double m_LambdaMax, m_LambdaMin;
-  double m_DiffValue, m_SqrtValue;
+    return numNodes;
+  }
 };
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "baseLogLikelihood.h"
+#include "lFunctionTable.h"
+
+//! Base of the models whose kernels are specialized on the domain dimension.
+//! TModel provides EvaluateKernel<d>() and EvaluateKernelDerivative<d>() for
+//! d = 1, 2 and 3, along with EvaluateGenericKernel() and
+//! EvaluateGenericKernelDerivative() for any dimension, and declares this
+//! class as a friend. The kernels are selected once in InitializeKernel().
+//! Spans of pairs then cost a single indirect call, the loop over the pairs
+//! being compiled with the kernel of TModel inlined so that it may be
+//! vectorized.
+//!
+//! The entries of the L-matrix are by default the kernels plus the residuals
+//! L - K tabulated by LFunctionTable from the Fourier kernels of TModel,
+//! which models with a closed form for L override.
+template <class TModel>
+class KernelLogLikelihood : public BaseLogLikelihood
+{
+public:
+  KernelLogLikelihood()
+  {
+    this->SelectGenericKernels();
+  }
+
+protected:
+  double EvaluateSpatialKernel(const double sqDist, const double alpha, const bool cross = false)
+  {
+    return (this->GetModel()->*m_KernelFunction)(sqDist, alpha, cross);
+  }
+
+  double EvaluateSpatialKernelDerivative(const double sqDist, const double alpha, const bool cross = false)
+  {
+    return (this->GetModel()->*m_KernelDerivativeFunction)(sqDist, alpha, cross);
+  }
+
+  void EvaluateSpatialKernels(
+      const double *sqDistances,
+      const unsigned int n,
+      const double alpha,
+      const bool cross,
+      double *values)
+  {
+    (this->*m_KernelSpanFunction)(sqDistances, n, alpha, cross, values);
+  }
+
+  void EvaluateSpatialKernelDerivatives(
+      const double *sqDistances,
+      const unsigned int n,
+      const double alpha,
+      const bool cross,
+      double *values)
+  {
+    (this->*m_KernelDerivativeSpanFunction)(sqDistances, n, alpha, cross, values);
+  }
+
+  void EvaluateLEntries(
+      const double *sqDistances,
+      const unsigned int n,
+      const unsigned int labelPair,
+      double *values,
+      double *workValues)
+  {
+    double amplitude = this->GetCrossAmplitude();
+    double alpha = this->GetInverseCrossAlpha();
+    if (labelPair != 1)
+    {
+      amplitude = (labelPair == 0) ? this->GetFirstAmplitude() : this->GetSecondAmplitude();
+      alpha = (labelPair == 0) ? this->GetFirstAlpha() : this->GetSecondAlpha();
+    }
+
+    this->EvaluateSpatialKernels(sqDistances, n, alpha, labelPair == 1, values);
+    for (unsigned int k = 0;k < n;++k)
+      values[k] = amplitude * values[k] + m_LFunctionTable.Evaluate(labelPair, std::sqrt(sqDistances[k]));
+  }
+
+  void EvaluateLDerivativeEntries(
+      const double *sqDistances,
+      const unsigned int n,
+      const unsigned int labelPair,
+      double *derivatives,
+      double *workValues)
+  {
+    // Only the kernel of the label pair depends on its own amplitude and
+    // alpha, whose indices among the natural parameters are 0 and 1 for 1-1,
+    // 4 and 5 for 1-2 and 2 and 3 for 2-2.
+    double amplitude = this->GetCrossAmplitude();
+    double alpha = this->GetInverseCrossAlpha();
+    unsigned int amplitudeIndex = 4;
+    if (labelPair != 1)
+    {
+      amplitude = (labelPair == 0) ? this->GetFirstAmplitude() : this->GetSecondAmplitude();
+      alpha = (labelPair == 0) ? this->GetFirstAlpha() : this->GetSecondAlpha();
+      amplitudeIndex = (labelPair == 0) ? 0 : 2;
+    }
+
+    double *kernelValues = workValues;
+    double *kernelDerivatives = workValues + n;
+    this->EvaluateSpatialKernels(sqDistances, n, alpha, labelPair == 1, kernelValues);
+    this->EvaluateSpatialKernelDerivatives(sqDistances, n, alpha, labelPair == 1, kernelDerivatives);
+
+    for (unsigned int j = 0;j < n;++j)
+    {
+      double *entryDerivatives = derivatives + 6 * j;
+      m_LFunctionTable.EvaluateDerivatives(labelPair, std::sqrt(sqDistances[j]), entryDerivatives);
+      entryDerivatives[amplitudeIndex] += kernelValues[j];
+      entryDerivatives[amplitudeIndex + 1] += amplitude * kernelDerivatives[j];
+    }
+  }
+
+  void UpdateLFunctions()
+  {
+    const TModel *model = this->GetModel();
+    unsigned int dimension = this->GetDomainDimension();
+    double amplitudes[3] = {this->GetFirstAmplitude(), this->GetCrossAmplitude(), this->GetSecondAmplitude()};
+    double alphas[3] = {this->GetFirstAlpha(), this->GetInverseCrossAlpha(), this->GetSecondAlpha()};
+
+    auto fourierFunction = [model, dimension, &alphas](const double radius, double *values, double *derivatives)
+    {
+      for (unsigned int i = 0;i < 3;++i)
+        values[i] = model->GetFourierKernel(radius, alphas[i], dimension, i == 1, derivatives[i]);
+    };
+
+    m_LFunctionTable.SetNumberOfThreads(this->GetNumberOfThreads());
+    m_LFunctionTable.Update(fourierFunction, amplitudes, alphas, this->GetMaximalDistance());
+  }
+
+  void ClearLFunctions() {m_LFunctionTable.Clear();}
+  bool AreLFunctionsCapped() const {return m_LFunctionTable.IsCapped();}
+
+  //! Selects the kernels for the domain dimension. Models precomputing other
+  //! quantities call it from their own InitializeKernel().
+  void InitializeKernel()
+  {
+    unsigned int dimension = this->GetDomainDimension();
+    m_LFunctionTable.SetDomainDimension(dimension);
+
+    if (dimension == 1)
+      this->SelectKernels<1>();
+    else if (dimension == 2)
+      this->SelectKernels<2>();
+    else if (dimension == 3)
+      this->SelectKernels<3>();
+    else
+      this->SelectGenericKernels();
+  }
+
+private:
+  typedef double (TModel::*KernelFunctionType)(const double, const double, const bool);
+  typedef void (KernelLogLikelihood::*KernelSpanFunctionType)(const double *, const unsigned int, const double, const bool, double *);
+
+  TModel *GetModel() {return static_cast<TModel *>(this);}
+
+  template <unsigned int TDimension>
+  void SelectKernels()
+  {
+    m_KernelFunction = &TModel::template EvaluateKernel<TDimension>;
+    m_KernelDerivativeFunction = &TModel::template EvaluateKernelDerivative<TDimension>;
+    m_KernelSpanFunction = &KernelLogLikelihood::template EvaluateKernelSpan<TDimension>;
+    m_KernelDerivativeSpanFunction = &KernelLogLikelihood::template EvaluateKernelDerivativeSpan<TDimension>;
+  }
+
+  void SelectGenericKernels()
+  {
+    m_KernelFunction = &TModel::EvaluateGenericKernel;
+    m_KernelDerivativeFunction = &TModel::EvaluateGenericKernelDerivative;
+    m_KernelSpanFunction = &KernelLogLikelihood::EvaluateGenericKernelSpan;
+    m_KernelDerivativeSpanFunction = &KernelLogLikelihood::EvaluateGenericKernelDerivativeSpan;
+  }
+
+  template <unsigned int TDimension>
+  void EvaluateKernelSpan(const double *sqDistances, const unsigned int n, const double alpha, const bool cross, double *values)
+  {
+    TModel *model = this->GetModel();
+    for (unsigned int k = 0;k < n;++k)
+      values[k] = model->template EvaluateKernel<TDimension>(sqDistances[k], alpha, cross);
+  }
+
+  void EvaluateGenericKernelSpan(const double *sqDistances, const unsigned int n, const double alpha, const bool cross, double *values)
+  {
+    TModel *model = this->GetModel();
+    for (unsigned int k = 0;k < n;++k)
+      values[k] = model->EvaluateGenericKernel(sqDistances[k], alpha, cross);
+  }
+
+  template <unsigned int TDimension>
+  void EvaluateKernelDerivativeSpan(const double *sqDistances, const unsigned int n, const double alpha, const bool cross, double *values)
+  {
+    TModel *model = this->GetModel();
+    for (unsigned int k = 0;k < n;++k)
+      values[k] = model->template EvaluateKernelDerivative<TDimension>(sqDistances[k], alpha, cross);
+  }
+
+  void EvaluateGenericKernelDerivativeSpan(const double *sqDistances, const unsigned int n, const double alpha, const bool cross, double *values)
+  {
+    TModel *model = this->GetModel();
+    for (unsigned int k = 0;k < n;++k)
+      values[k] = model->EvaluateGenericKernelDerivative(sqDistances[k], alpha, cross);
+  }
+
+  KernelFunctionType m_KernelFunction, m_KernelDerivativeFunction;
+  LFunctionTable m_LFunctionTable;
+  KernelSpanFunctionType m_KernelSpanFunction, m_KernelDerivativeSpanFunction;
+};
@@ -0,0 +1,411 @@
+#include "lFunctionTable.h"
+#include "dimensionTraits.h"
+#include "parallelErrorHandler.h"
+#include <boost/math/quadrature/gauss.hpp>
+#include <boost/math/special_functions/bessel.hpp>
+
+const double LFunctionTable::m_Tolerance = 1.0e-10;
+const double LFunctionTable::m_RatioTolerance = 1.0e-13;
+const unsigned int LFunctionTable::m_NodesPerScale = 16;
+const unsigned int LFunctionTable::m_BlockSize = 64;
+const unsigned int LFunctionTable::m_MaximalNumberOfNodes = 8192;
+const unsigned int LFunctionTable::m_MaximalNumberOfQuadratureNodes = 8192;
+const unsigned int LFunctionTable::m_MaximalNumberOfScanSteps = 1000;
+const double LFunctionTable::m_RangeFactor = 8.0;
+const double LFunctionTable::m_PeriodsPerPanel = 8.0;
+
+void LFunctionTable::SetDomainDimension(const unsigned int d)
+{
+  if (d == m_DomainDimension)
+    return;
+
+  m_DomainDimension = d;
+  this->Clear();
+  m_FirstRatioTable.Clear();
+  m_SecondRatioTable.Clear();
+}
+
+void LFunctionTable::Clear()
+{
+  m_IsBuilt = false;
+  m_IsCapped = false;
+  m_Step = 0.0;
+  m_InverseStep = 0.0;
+  m_LastPosition = 0.0;
+  m_QuadratureNodes.clear();
+  m_QuadratureValues.clear();
+  m_Values.clear();
+  m_ScaledDerivatives.clear();
+}
+
+void LFunctionTable::GetBesselJRatios(const double x, double &firstValue, double &secondValue) const
+{
+  if (m_DomainDimension == 1)
+  {
+    // J_(-1/2)(x) / (x / 2)^(-1/2) = cos(x) / sqrt(pi)
+    firstValue = 0.5 * M_2_SQRTPI * std::cos(x);
+    secondValue = HalfIntegerBesselJRatio<1>::Evaluate(x);
+    return;
+  }
+
+  if (m_DomainDimension == 3)
+  {
+    firstValue = HalfIntegerBesselJRatio<1>::Evaluate(x);
+    secondValue = HalfIntegerBesselJRatio<3>::Evaluate(x);
+    return;
+  }
+
+  firstValue = m_FirstRatioTable.Evaluate(x);
+  secondValue = m_SecondRatioTable.Evaluate(x);
+}
+
+void LFunctionTable::GetSpectralResiduals(
+    const FourierFunctionType &fourierFunction,
+    const double amplitudes[3],
+    const double radius,
+    double *values)
+{
+  double kernelValues[3], kernelDerivatives[3];
+  fourierFunction(radius, kernelValues, kernelDerivatives);
+
+  double aValue = amplitudes[0] * kernelValues[0];
+  double cValue = amplitudes[1] * kernelValues[1];
+  double bValue = amplitudes[2] * kernelValues[2];
+  double sqCrossValue = cValue * cValue;
+  double prodValue = (1.0 - aValue) * (1.0 - bValue);
+  double detValue = prodValue - sqCrossValue;
+  double inverseValue = 1.0 / detValue;
+  double sqInverseValue = inverseValue * inverseValue;
+
+  // Residuals and their derivatives w.r.t. (a, b, c) for each label pair
+  double residualValues[3];
+  double derivativeValues[3][3];
+
+  residualValues[0] = (aValue * aValue * (1.0 - bValue) + sqCrossValue * (1.0 + aValue)) * inverseValue;
+  derivativeValues[0][0] = (aValue * (1.0 - bValue) + sqCrossValue) * (1.0 - bValue + detValue) * sqInverseValue;
+  derivativeValues[0][1] = sqCrossValue * sqInverseValue;
+  derivativeValues[0][2] = 2.0 * cValue * (1.0 - bValue) * sqInverseValue;
+
+  double sumValue = aValue + bValue - aValue * bValue;
+  residualValues[1] = cValue * (sumValue + sqCrossValue) * inverseValue;
+  derivativeValues[1][0] = cValue * (1.0 - bValue) * sqInverseValue;
+  derivativeValues[1][1] = cValue * (1.0 - aValue) * sqInverseValue;
+  derivativeValues[1][2] = (prodValue * sumValue + sqCrossValue * (1.0 + 2.0 * prodValue - sqCrossValue)) * sqInverseValue;
+
+  residualValues[2] = (bValue * bValue * (1.0 - aValue) + sqCrossValue * (1.0 + bValue)) * inverseValue;
+  derivativeValues[2][0] = sqCrossValue * sqInverseValue;
+  derivativeValues[2][1] = (bValue * (1.0 - aValue) + sqCrossValue) * (1.0 - aValue + detValue) * sqInverseValue;
+  derivativeValues[2][2] = 2.0 * cValue * (1.0 - aValue) * sqInverseValue;
+
+  // Chain rule to (k1, alpha1, k2, alpha2, k12, 1 / alpha12)
+  for (unsigned int i = 0;i < 3;++i)
+  {
+    double *pairValues = values + 7 * i;
+    pairValues[0] = residualValues[i];
+    pairValues[1] = derivativeValues[i][0] * kernelValues[0];
+    pairValues[2] = derivativeValues[i][0] * amplitudes[0] * kernelDerivatives[0];
+    pairValues[3] = derivativeValues[i][1] * kernelValues[2];
+    pairValues[4] = derivativeValues[i][1] * amplitudes[2] * kernelDerivatives[2];
+    pairValues[5] = derivativeValues[i][2] * kernelValues[1];
+    pairValues[6] = derivativeValues[i][2] * amplitudes[1] * kernelDerivatives[1];
+  }
+}
+
+double LFunctionTable::GetMaximalFrequency(
+    const FourierFunctionType &fourierFunction,
+    const double amplitudes[3],
+    const double minimalScale,
+    const double maximalScale) const
+{
+  // Geometric scan of t^d |R(t)|, the contribution of the neighbourhood of t
+  // to the transform at r = 0, until each component is negligible w.r.t. its
+  // maximum, past the main lobe of the widest Fourier kernel
+  std::vector<double> values(NumberOfComponents);
+  std::vector<double> maximalValues(NumberOfComponents, 0.0);
+  double radius = 0.125 / maximalScale;
+  double lobeRadius = 1.0 / minimalScale;
+
+  for (unsigned int k = 0;k < m_MaximalNumberOfScanSteps;++k)
+  {
+    GetSpectralResiduals(fourierFunction, amplitudes, radius, values.data());
+    double measureValue = std::pow(radius, (double)m_DomainDimension);
+    bool isNegligible = (radius >= lobeRadius);
+
+    for (unsigned int c = 0;c < NumberOfComponents;++c)
+    {
+      double workValue = std::abs(values[c]) * measureValue;
+      maximalValues[c] = std::max(maximalValues[c], workValue);
+      if (workValue > m_Tolerance * maximalValues[c])
+        isNegligible = false;
+    }
+
+    if (isNegligible)
+      break;
+
+    radius *= 1.05;
+  }
+
+  return radius;
+}
+
+void LFunctionTable::SetQuadrature(
+    const FourierFunctionType &fourierFunction,
+    const double amplitudes[3],
+    const double maximalFrequency,
+    const double distance,
+    const double maximalScale,
+    const double detValue)
+{
+  typedef boost::math::quadrature::gauss<double, 30> QuadratureType;
+  unsigned int maximalNumberOfPanels = m_MaximalNumberOfQuadratureNodes / 30;
+
+  // A panel holds about one period of J_nu(2 pi r t) in t at the largest
+  // distance, and about one scale of the narrowest Fourier kernel. Near the
+  // origin, 1 / D peaks over a width of order sqrt(D(0)) times the latter.
+  double maximalWidth = m_PeriodsPerPanel / std::max(distance, maximalScale);
+  double minimalWidth = std::sqrt(std::max(std::min(detValue, 1.0), 0.0)) / (M_PI * maximalScale);
+  minimalWidth = std::max(minimalWidth, 1.0e-9 * maximalWidth);
+  std::vector<double> panelEdges;
+
+  while (true)
+  {
+    minimalWidth = std::min(minimalWidth, maximalWidth);
+    panelEdges.clear();
+    panelEdges.push_back(0.0);
+
+    double widthValue = minimalWidth;
+    while (panelEdges.back() < maximalFrequency && panelEdges.size() <= maximalNumberOfPanels + 1)
+    {
+      panelEdges.push_back(std::min(panelEdges.back() + widthValue, maximalFrequency));
+      widthValue = std::min(2.0 * widthValue, maximalWidth);
+    }
+
+    if (panelEdges.size() <= maximalNumberOfPanels + 1)
+      break;
+
+    // Panels no longer resolve the oscillations at the given distance
+    maximalWidth *= 2.0;
+    m_IsCapped = true;
+  }
+
+  m_QuadratureNodes.clear();
+  std::vector<double> quadratureWeights;
+  auto abscissaValues = QuadratureType::abscissa();
+  auto weightValues = QuadratureType::weights();
+
+  for (unsigned int j = 0;j < panelEdges.size() - 1;++j)
+  {
+    double centerValue = 0.5 * (panelEdges[j] + panelEdges[j + 1]);
+    double halfWidth = 0.5 * (panelEdges[j + 1] - panelEdges[j]);
+
+    for (unsigned int i = 0;i < abscissaValues.size();++i)
+    {
+      m_QuadratureNodes.push_back(centerValue + halfWidth * abscissaValues[i]);
+      quadratureWeights.push_back(halfWidth * weightValues[i]);
+      if (abscissaValues[i] == 0.0)
+        continue;
+      m_QuadratureNodes.push_back(centerValue - halfWidth * abscissaValues[i]);
+      quadratureWeights.push_back(halfWidth * weightValues[i]);
+    }
+  }
+
+  // Weights times the radial measure 2 pi^(d / 2) t^(d - 1)
+  unsigned int numNodes = m_QuadratureNodes.size();
+  double dimValue = (double)m_DomainDimension;
+  double factorValue = 2.0 * std::pow(M_PI, dimValue / 2.0);
+  m_QuadratureValues.resize(numNodes * NumberOfComponents);
+  ParallelErrorHandler errorHandler;
+
+#ifdef _OPENMP
+  #pragma omp parallel for num_threads(m_NumberOfThreads)
+#endif
+  for (unsigned int q = 0;q < numNodes;++q)
+  {
+    try
+    {
+      double radius = m_QuadratureNodes[q];
+      double *values = &(m_QuadratureValues[q * NumberOfComponents]);
+      GetSpectralResiduals(fourierFunction, amplitudes, radius, values);
+      double weightValue = factorValue * quadratureWeights[q] * std::pow(radius, dimValue - 1.0);
+      for (unsigned int c = 0;c < NumberOfComponents;++c)
+        values[c] *= weightValue;
+    }
+    catch (std::exception &e)
+    {
+      errorHandler.Store(q, e);
+    }
+  }
+
+  errorHandler.Rethrow();
+}
+
+void LFunctionTable::IntegrateNode(const double distance, double *values, double *derivatives) const
+{
+  for (unsigned int c = 0;c < NumberOfComponents;++c)
+  {
+    values[c] = 0.0;
+    derivatives[c] = 0.0;
+  }
+
+  // d/dr J_nu(2 pi r t) / (pi r t)^nu = -2 pi^2 r t^2 J_(nu + 1)(2 pi r t) / (pi r t)^(nu + 1)
+  unsigned int numNodes = m_QuadratureNodes.size();
+  for (unsigned int q = 0;q < numNodes;++q)
+  {
+    double radius = m_QuadratureNodes[q];
+    double firstValue, secondValue;
+    this->GetBesselJRatios(2.0 * M_PI * distance * radius, firstValue, secondValue);
+    secondValue *= radius * radius;
+
+    const double *nodeValues = &(m_QuadratureValues[q * NumberOfComponents]);
+    for (unsigned int c = 0;c < NumberOfComponents;++c)
+    {
+      values[c] += nodeValues[c] * firstValue;
+      derivatives[c] += nodeValues[c] * secondValue;
+    }
+  }
+
+  double factorValue = -2.0 * M_PI * M_PI * distance;
+  for (unsigned int c = 0;c < NumberOfComponents;++c)
+    derivatives[c] *= factorValue;
+}
+
+void LFunctionTable::Update(
+    const FourierFunctionType &fourierFunction,
+    const double amplitudes[3],
+    const double alphas[3],
+    const double maximalDistance)
+{
+  if (m_IsBuilt && maximalDistance == m_MaximalDistance)
+  {
+    bool isUpToDate = true;
+    for (unsigned int i = 0;i < 3;++i)
+    {
+      if (amplitudes[i] != m_Amplitudes[i] || alphas[i] != m_Alphas[i])
+        isUpToDate = false;
+    }
+
+    if (isUpToDate)
+      return;
+  }
+
+  this->Clear();
+
+  // Closed forms for d = 1 and 3
+  if (m_DomainDimension != 1 && m_DomainDimension != 3 && !m_FirstRatioTable.IsBuilt())
+  {
+    double order = (double)m_DomainDimension / 2.0 - 1.0;
+    m_FirstRatioTable.Build(order, m_RatioTolerance);
+    m_SecondRatioTable.Build(order + 1.0, m_RatioTolerance);
+  }
+
+  for (unsigned int i = 0;i < 3;++i)
+  {
+    m_Amplitudes[i] = amplitudes[i];
+    m_Alphas[i] = alphas[i];
+  }
+  m_MaximalDistance = maximalDistance;
+
+  // alphas[1] is the inverse of the cross alpha
+  double minimalScale = std::min(std::min(alphas[0], alphas[2]), 1.0 / alphas[1]);
+  double maximalScale = std::max(std::max(alphas[0], alphas[2]), 1.0 / alphas[1]);
+  double detValue = (1.0 - amplitudes[0]) * (1.0 - amplitudes[2]) - amplitudes[1] * amplitudes[1];
+  double maximalFrequency = this->GetMaximalFrequency(fourierFunction, amplitudes, minimalScale, maximalScale);
+
+  // Expected range of the residuals, which grows as D(0) vanishes
+  double rangeValue = maximalDistance;
+  if (detValue > 0.0)
+    rangeValue = m_RangeFactor * maximalScale / std::sqrt(std::min(detValue, 1.0));
+  double quadratureDistance = std::min(maximalDistance, rangeValue);
+  this->SetQuadrature(fourierFunction, amplitudes, maximalFrequency, quadratureDistance, maximalScale, detValue);
+
+  m_Step = minimalScale / (double)m_NodesPerScale;
+  if (quadratureDistance / (double)m_MaximalNumberOfNodes > m_Step)
+  {
+    m_Step = quadratureDistance / (double)m_MaximalNumberOfNodes;
+    m_IsCapped = true;
+  }
+  if (!(m_Step > 0.0))
+    m_Step = 1.0;
+  m_InverseStep = 1.0 / m_Step;
+
+  // Nodes up to past the largest distance, computed by blocks until the
+  // residuals have been negligible over the largest scale
+  double numberOfDistanceNodes = std::ceil(maximalDistance * m_InverseStep) + 2.0;
+  unsigned int maximalNumberOfNodes = (unsigned int)std::min(numberOfDistanceNodes, (double)m_MaximalNumberOfNodes);
+  bool isNegligible = false;
+  unsigned int spanLength = (unsigned int)std::ceil(maximalScale * m_InverseStep);
+  std::vector<double> maximalValues(NumberOfComponents, 0.0);
+  unsigned int lastSignificantIndex = 0;
+  unsigned int numNodes = 0;
+
+  while (numNodes < maximalNumberOfNodes)
+  {
+    unsigned int blockEnd = std::min(numNodes + m_BlockSize, maximalNumberOfNodes);
+
+    // Finer panels as the grid goes beyond the quadrature distance
+    double blockDistance = (double)(blockEnd - 1) * m_Step;
+    if (blockDistance > quadratureDistance && quadratureDistance < maximalDistance)
+    {
+      while (quadratureDistance < std::min(blockDistance, maximalDistance))
+        quadratureDistance = std::min(2.0 * quadratureDistance, maximalDistance);
+      this->SetQuadrature(fourierFunction, amplitudes, maximalFrequency, quadratureDistance, maximalScale, detValue);
+    }
+
+    m_Values.resize(blockEnd * NumberOfComponents);
+    m_ScaledDerivatives.resize(blockEnd * NumberOfComponents);
+    ParallelErrorHandler errorHandler;
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads(m_NumberOfThreads)
+#endif
+    for (unsigned int i = numNodes;i < blockEnd;++i)
+    {
+      try
+      {
+        double *values = &(m_Values[i * NumberOfComponents]);
+        double *derivatives = &(m_ScaledDerivatives[i * NumberOfComponents]);
+        this->IntegrateNode((double)i * m_Step, values, derivatives);
+        for (unsigned int c = 0;c < NumberOfComponents;++c)
+          derivatives[c] *= m_Step;
+      }
+      catch (std::exception &e)
+      {
+        errorHandler.Store(i, e);
+      }
+    }
+
+    errorHandler.Rethrow();
+
+    for (unsigned int i = numNodes;i < blockEnd;++i)
+    {
+      for (unsigned int c = 0;c < NumberOfComponents;++c)
+        maximalValues[c] = std::max(maximalValues[c], std::abs(m_Values[i * NumberOfComponents + c]));
+    }
+
+    for (unsigned int i = numNodes;i < blockEnd;++i)
+    {
+      for (unsigned int c = 0;c < NumberOfComponents;++c)
+      {
+        if (std::abs(m_Values[i * NumberOfComponents + c]) > m_Tolerance * maximalValues[c])
+        {
+          lastSignificantIndex = i;
+          break;
+        }
+      }
+    }
+
+    numNodes = blockEnd;
+    if (numNodes - 1 - lastSignificantIndex >= spanLength)
+    {
+      isNegligible = true;
+      break;
+    }
+  }
+
+  // Residuals beyond the grid are taken as 0 while still significant
+  if (!isNegligible && (double)maximalNumberOfNodes < numberOfDistanceNodes)
+    m_IsCapped = true;
+
+  m_LastPosition = (double)(numNodes - 1);
+  m_IsBuilt = true;
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include "besselJRatioTable.h"
+#include <functional>
+#include <vector>
+
+//! Lookup table of the entries of the L-matrix beyond the kernels, for the
+//! models whose Fourier kernels lead to no closed form. With Fourier kernels
+//! K1, K2 and K12 of amplitudes k1, k2 and k12 at a frequency t, the Fourier
+//! transform of L = K (I - K)^-1 reads
+//!   L12 = K12 / D and L11 = (K1 (1 - K2) + K12^2) / D,
+//! with D = (1 - K1) (1 - K2) - K12^2, and symmetrically for L22. The
+//! residuals R = L - K, e.g. R12 = K12 (K1 + K2 - K1 K2 + K12^2) / D, decay
+//! like the square of the kernels so that their radial inverse transform
+//!   R(r) = 2 pi^(d / 2) int_0^inf R(t) t^(d - 1) J_nu(2 pi r t) / (pi r t)^nu dt,
+//! with nu = d / 2 - 1, converges quickly, the kernels themselves being
+//! evaluated in closed form by the models. The three residuals and their
+//! partial derivatives w.r.t. the natural parameters (k1, alpha1, k2, alpha2,
+//! k12, 1 / alpha12) are integrated at once by composite Gauss-Legendre
+//! quadrature at the nodes of a uniform grid of distances, along with their
+//! derivatives w.r.t. r, and evaluated by cubic Hermite interpolation.
+//!
+//! The grid step is a fraction of the smallest spatial scale of the kernels.
+//! The grid stops once all residuals have stayed negligible over the largest
+//! scale, beyond which they are taken as 0, or past the largest distance
+//! between two points. Both the grid and the quadrature are capped in size,
+//! which degrades the accuracy when the spatial scales of the kernels differ
+//! by several orders of magnitude. IsCapped() tells whether the last build
+//! hit one of the caps.
+class LFunctionTable
+{
+public:
+  //! Value and six partial derivatives for each of the label pairs 1-1, 1-2
+  //! and 2-2
+  static const unsigned int NumberOfComponents = 21;
+
+  //! Fourier kernels of unit amplitude in the order 1, 12, 2 at a frequency,
+  //! along with their derivatives w.r.t. alpha1, 1 / alpha12 and alpha2
+  typedef std::function<void(const double, double *, double *)> FourierFunctionType;
+
+  LFunctionTable()
+  {
+    m_DomainDimension = 0;
+    m_NumberOfThreads = 1;
+    m_Step = 0.0;
+    m_InverseStep = 0.0;
+    m_LastPosition = 0.0;
+    m_IsBuilt = false;
+    m_IsCapped = false;
+    m_MaximalDistance = 0.0;
+  }
+
+  ~LFunctionTable() {}
+
+  void SetDomainDimension(const unsigned int d);
+  void SetNumberOfThreads(const unsigned int n) {m_NumberOfThreads = (n > 0) ? n : 1;}
+
+  //! Tabulates the residuals for the amplitudes (k1, k12, k2) and the alphas
+  //! (alpha1, 1 / alpha12, alpha2) up to the given distance, unless the table
+  //! was already built for the same inputs. The Bessel J ratios of the
+  //! transform are tabulated on first use for d other than 1 and 3.
+  void Update(
+      const FourierFunctionType &fourierFunction,
+      const double amplitudes[3],
+      const double alphas[3],
+      const double maximalDistance);
+
+  bool IsBuilt() const {return m_IsBuilt;}
+
+  //! Whether the last build was coarsened by the cap on the quadrature
+  //! nodes or on the grid nodes, the latter either widening the step beyond
+  //! a fraction of the smallest scale or setting to 0 residuals which were
+  //! not negligible yet
+  bool IsCapped() const {return m_IsCapped;}
+
+  void Clear();
+  unsigned int GetNumberOfNodes() const {return m_Values.size() / NumberOfComponents;}
+  unsigned int GetNumberOfQuadratureNodes() const {return m_QuadratureNodes.size();}
+  double GetStep() const {return m_Step;}
+
+  //! Residual of a label pair 1-1 (labelPair = 0), 1-2 (1) or 2-2 (2) at a
+  //! distance
+  double Evaluate(const unsigned int labelPair, const double distance) const
+  {
+    double workPosition = distance * m_InverseStep;
+    if (!(workPosition < m_LastPosition))
+      return 0.0;
+
+    unsigned int pos = (unsigned int)workPosition;
+    double t = workPosition - (double)pos;
+    double t2 = t * t;
+    double t3 = t2 * t;
+    unsigned int index = pos * NumberOfComponents + 7 * labelPair;
+
+    double resVal = (2.0 * t3 - 3.0 * t2 + 1.0) * m_Values[index];
+    resVal += (t3 - 2.0 * t2 + t) * m_ScaledDerivatives[index];
+    resVal += (3.0 * t2 - 2.0 * t3) * m_Values[index + NumberOfComponents];
+    resVal += (t3 - t2) * m_ScaledDerivatives[index + NumberOfComponents];
+
+    return resVal;
+  }
+
+  //! Partial derivatives of the residual w.r.t. the natural parameters
+  void EvaluateDerivatives(const unsigned int labelPair, const double distance, double *derivatives) const
+  {
+    double workPosition = distance * m_InverseStep;
+    if (!(workPosition < m_LastPosition))
+    {
+      for (unsigned int k = 0;k < 6;++k)
+        derivatives[k] = 0.0;
+      return;
+    }
+
+    unsigned int pos = (unsigned int)workPosition;
+    double t = workPosition - (double)pos;
+    double t2 = t * t;
+    double t3 = t2 * t;
+    double firstWeight = 2.0 * t3 - 3.0 * t2 + 1.0;
+    double secondWeight = t3 - 2.0 * t2 + t;
+    double thirdWeight = 3.0 * t2 - 2.0 * t3;
+    double fourthWeight = t3 - t2;
+    unsigned int index = pos * NumberOfComponents + 7 * labelPair + 1;
+
+    for (unsigned int k = 0;k < 6;++k)
+    {
+      double resVal = firstWeight * m_Values[index + k];
+      resVal += secondWeight * m_ScaledDerivatives[index + k];
+      resVal += thirdWeight * m_Values[index + NumberOfComponents + k];
+      resVal += fourthWeight * m_ScaledDerivatives[index + NumberOfComponents + k];
+      derivatives[k] = resVal;
+    }
+  }
+
+  //! Residuals of L - K and their partial derivatives at a frequency, in the
+  //! layout of the table
+  static void GetSpectralResiduals(
+      const FourierFunctionType &fourierFunction,
+      const double amplitudes[3],
+      const double radius,
+      double *values);
+
+private:
+  //! J_nu(x) / (x / 2)^nu for nu = d / 2 - 1 and d / 2
+  void GetBesselJRatios(const double x, double &firstValue, double &secondValue) const;
+
+  //! Frequency beyond which the spectral residuals are negligible
+  double GetMaximalFrequency(
+      const FourierFunctionType &fourierFunction,
+      const double amplitudes[3],
+      const double minimalScale,
+      const double maximalScale) const;
+
+  //! Composite rule over [0, maximal frequency], graded near the origin
+  //! where 1 / D peaks, with panels resolving the oscillations of the Bessel
+  //! functions up to the given distance
+  void SetQuadrature(
+      const FourierFunctionType &fourierFunction,
+      const double amplitudes[3],
+      const double maximalFrequency,
+      const double distance,
+      const double maximalScale,
+      const double detValue);
+
+  //! Residuals and their derivatives w.r.t. r at a distance
+  void IntegrateNode(const double distance, double *values, double *derivatives) const;
+
+  unsigned int m_DomainDimension, m_NumberOfThreads;
+  double m_Step, m_InverseStep, m_LastPosition;
+  bool m_IsBuilt, m_IsCapped;
+
+  //! Inputs of the last build
+  double m_Amplitudes[3], m_Alphas[3], m_MaximalDistance;
+
+  //! Quadrature nodes and the spectral residuals times the weights and the
+  //! radial measure, NumberOfComponents per node
+  std::vector<double> m_QuadratureNodes, m_QuadratureValues;
+
+  std::vector<double> m_Values, m_ScaledDerivatives;
+  BesselJRatioTable m_FirstRatioTable, m_SecondRatioTable;
+
+  static const double m_Tolerance;
+  static const double m_RatioTolerance;
+  static const unsigned int m_NodesPerScale;
+  static const unsigned int m_BlockSize;
+  static const unsigned int m_MaximalNumberOfNodes;
+  static const unsigned int m_MaximalNumberOfQuadratureNodes;
+  static const unsigned int m_MaximalNumberOfScanSteps;
+  static const double m_RangeFactor;
+  static const double m_PeriodsPerPanel;
+};
@@ -0,0 +1,134 @@
+#include <RcppEnsmallen.h>
+#include "baseLogLikelihood.h"
+
+// [[Rcpp::export]]
+double EvaluateLogLikelihood(const arma::vec &p, SEXP likelihood)
+{
+  // The likelihood handle is created once by one of the Create*LogLikelihood()
+  // functions and holds the prepared inputs of the model.
+  Rcpp::XPtr<BaseLogLikelihood> logLik(likelihood);
+
+  arma::mat params(p.n_elem, 1);
+  for (unsigned int i = 0;i < p.n_elem;++i)
+    params[i] = p[i];
+
+  double resVal = logLik->Evaluate(params);
+  logLik->WarnCappedLFunctions();
+
+  return resVal;
+}
+
+// [[Rcpp::export]]
+arma::vec EvaluateLogLikelihoodGradient(const arma::vec &p, SEXP likelihood)
+{
+  Rcpp::XPtr<BaseLogLikelihood> logLik(likelihood);
+
+  arma::mat params(p.n_elem, 1);
+  for (unsigned int i = 0;i < p.n_elem;++i)
+    params[i] = p[i];
+
+  arma::mat gradient;
+  logLik->Gradient(params, gradient);
+  logLik->WarnCappedLFunctions();
+
+  arma::vec resVec(p.n_elem);
+  for (unsigned int i = 0;i < p.n_elem;++i)
+    resVec[i] = gradient[i];
+
+  return resVec;
+}
+
+// [[Rcpp::export]]
+arma::mat CheckLogLikelihoodGradient(const arma::vec &p, SEXP likelihood, const double step = 1.0e-6)
+{
+  // Analytic gradient in the first column against central finite differences
+  // in the second one.
+  Rcpp::XPtr<BaseLogLikelihood> logLik(likelihood);
+  unsigned int numParams = p.n_elem;
+  arma::mat resMat(numParams, 2);
+
+  arma::vec gradient = EvaluateLogLikelihoodGradient(p, likelihood);
+
+  arma::mat params(numParams, 1);
+  for (unsigned int i = 0;i < numParams;++i)
+    params[i] = p[i];
+
+  for (unsigned int i = 0;i < numParams;++i)
+  {
+    arma::mat workParams = params;
+    workParams[i] = p[i] + step;
+    double upperValue = logLik->Evaluate(workParams);
+    workParams[i] = p[i] - step;
+    double lowerValue = logLik->Evaluate(workParams);
+
+    resMat(i, 0) = gradient[i];
+    resMat(i, 1) = (upperValue - lowerValue) / (2.0 * step);
+  }
+
+  return resMat;
+}
+
+// [[Rcpp::export]]
+double GetLogDeterminantError(SEXP likelihood)
+{
+  // Standard error of the log-determinant at the last evaluated parameters
+  // over the random probes, which only differs from zero with the stochastic
+  // estimator or the single precision correction, to which the estimate of
+  // the truncation error of the correction is added. It estimates the error
+  // but does not bound it.
+  Rcpp::XPtr<BaseLogLikelihood> logLik(likelihood);
+  return logLik->GetLogDeterminantError();
+}
+
+// [[Rcpp::export]]
+Rcpp::List GetLogLikelihoodProfile(SEXP likelihood)
+{
+  // Counters and timers accumulated since the creation of the handle, if it
+  // was created with profile = TRUE.
+  Rcpp::XPtr<BaseLogLikelihood> logLik(likelihood);
+  return logLik->GetProfile();
+}
+
+// [[Rcpp::export]]
+Rcpp::List TimeLogLikelihood(const arma::vec &p, SEXP likelihood, const unsigned int num_repeats = 1)
+{
+  // Phases of one evaluation timed separately, for the scripts in bench/.
+  Rcpp::XPtr<BaseLogLikelihood> logLik(likelihood);
+
+  arma::mat params(p.n_elem, 1);
+  for (unsigned int i = 0;i < p.n_elem;++i)
+    params[i] = p[i];
+
+  arma::vec timings = logLik->TimeEvaluation(params, num_repeats);
+
+  return Rcpp::List::create(
+    Rcpp::Named("integral_time") = timings[0],
+    Rcpp::Named("log_determinant_time") = timings[1],
+    Rcpp::Named("gradient_time") = timings[2],
+    Rcpp::Named("evaluate_time") = timings[3],
+    Rcpp::Named("value") = logLik->Evaluate(params)
+  );
+}
+
+// [[Rcpp::export]]
+Rcpp::List EvaluateLMatrixEntries(const arma::vec &p, SEXP likelihood, const arma::vec &r)
+{
+  // Entries of the L-matrix at the distances r for the label pairs 1-1, 1-2
+  // and 2-2, in columns, along with the natural parameters (k1, alpha1, k2,
+  // alpha2, k12, 1 / alpha12), for checking them against an independent
+  // computation of K (I - K)^-1.
+  Rcpp::XPtr<BaseLogLikelihood> logLik(likelihood);
+
+  arma::mat params(p.n_elem, 1);
+  for (unsigned int i = 0;i < p.n_elem;++i)
+    params[i] = p[i];
+
+  arma::vec naturalParameters;
+  arma::mat values = logLik->GetLEntries(params, r, naturalParameters);
+  logLik->WarnCappedLFunctions();
+
+  return Rcpp::List::create(
+    Rcpp::Named("parameters") = naturalParameters,
+    Rcpp::Named("values") = values
+  );
+}
@@ -0,0 +1,189 @@
+#include "maternCorrelationTable.h"
+#include <boost/math/special_functions/bessel.hpp>
+#include <boost/math/special_functions/gamma.hpp>
+
+const unsigned int MaternCorrelationTable::m_MaximalNumberOfNodes = 1 << 22;
+const double MaternCorrelationTable::m_SmoothnessThreshold = 2.5;
+const double MaternCorrelationTable::m_OverflowMargin = 10.0;
+
+double MaternCorrelationTable::GetExactValue(const double x, const double smoothness)
+{
+  if (x < std::numeric_limits<double>::epsilon())
+    return 1.0;
+
+  if (x < GetSeriesThreshold(smoothness))
+    return GetSeriesValue(x, smoothness);
+
+  double logValue = (1.0 - smoothness) * std::log(2.0) - boost::math::lgamma(smoothness);
+  logValue += smoothness * std::log(x);
+  return std::exp(logValue) * boost::math::cyl_bessel_k(smoothness, x);
+}
+
+double MaternCorrelationTable::GetExactDerivative(const double x, const double smoothness)
+{
+  if (x < std::numeric_limits<double>::epsilon())
+    return (smoothness > 0.5) ? 0.0 : -std::numeric_limits<double>::infinity();
+
+  if (x < GetSeriesThreshold(smoothness))
+  {
+    double resVal = 0.0;
+    GetSeriesValue(x, smoothness, &resVal);
+    return resVal;
+  }
+
+  // K_(-nu) = K_nu
+  double logValue = (1.0 - smoothness) * std::log(2.0) - boost::math::lgamma(smoothness);
+  logValue += smoothness * std::log(x);
+  return -std::exp(logValue) * boost::math::cyl_bessel_k(std::abs(smoothness - 1.0), x);
+}
+
+double MaternCorrelationTable::GetSeriesThreshold(const double smoothness)
+{
+  // u^nu K_nu(u) decreases to 2^(nu - 1) Gamma(nu) at the origin, so that
+  // K_nu(u) is bounded by 2^(nu - 1) Gamma(nu) / u^nu. The threshold keeps
+  // this bound a factor exp(m_OverflowMargin) below the largest double, which
+  // also covers K_(nu - 1) in the derivative.
+  double logValue = (smoothness - 1.0) * std::log(2.0) + boost::math::lgamma(smoothness);
+  logValue -= std::log(std::numeric_limits<double>::max()) - m_OverflowMargin;
+  return std::exp(logValue / smoothness);
+}
+
+double MaternCorrelationTable::GetSeriesValue(const double x, const double smoothness, double *derivative)
+{
+  // Terms Gamma(nu - k) / (Gamma(nu) k!) (-u^2 / 4)^k for k < nu, the
+  // derivative of the k-th one being 2 k / u times its value
+  double sqValue = -0.25 * x * x;
+  double termValue = 1.0;
+  double resVal = 1.0;
+  double derivValue = 0.0;
+
+  for (unsigned int k = 1;(double)k < smoothness;++k)
+  {
+    termValue *= sqValue / ((double)k * (smoothness - (double)k));
+    resVal += termValue;
+    derivValue += 2.0 * (double)k * termValue / x;
+
+    if (std::abs(termValue) < std::numeric_limits<double>::epsilon() * std::abs(resVal))
+      break;
+  }
+
+  if (derivative)
+    *derivative = derivValue;
+
+  return resVal;
+}
+
+void MaternCorrelationTable::Clear()
+{
+  m_Smoothness = NA_REAL;
+  m_Tolerance = NA_REAL;
+  m_Values.clear();
+  m_ScaledDerivatives.clear();
+}
+
+void MaternCorrelationTable::Build(const double smoothness, const double tolerance)
+{
+  m_Smoothness = smoothness;
+  m_Tolerance = std::max(tolerance, 10.0 * std::numeric_limits<double>::epsilon());
+
+  // M is decreasing so that the cutoff is found by a simple scan
+  m_Cutoff = 1.0;
+  while (GetExactValue(m_Cutoff, m_Smoothness) > m_Tolerance)
+    m_Cutoff *= 1.1;
+
+  // The fourth derivative of M is bounded at the origin only for nu > 2
+  m_ExactThreshold = (m_Smoothness < m_SmoothnessThreshold) ? 1.0 : 0.0;
+
+  // Start from the cubic Hermite bound with unit fourth derivative
+  double step = std::pow(384.0 * m_Tolerance, 0.25);
+
+  while (true)
+  {
+    this->SetNodes(step);
+
+    if (2 * m_Values.size() > m_MaximalNumberOfNodes)
+      break;
+
+    double maxError = 0.0;
+    unsigned int firstIndex = (unsigned int)std::floor(m_ExactThreshold * m_InverseStep) + 1;
+    for (unsigned int i = firstIndex;i < m_Values.size() - 1;++i)
+    {
+      double x = ((double)i + 0.5) * m_Step;
+      maxError = std::max(maxError, std::abs(this->GetInterpolatedValue(x) - GetExactValue(x, m_Smoothness)));
+    }
+
+    if (maxError < m_Tolerance)
+      break;
+
+    step /= 2.0;
+  }
+}
+
+void MaternCorrelationTable::SetNodes(const double step)
+{
+  m_Step = step;
+  m_InverseStep = 1.0 / step;
+  unsigned int numNodes = (unsigned int)std::ceil(m_Cutoff / m_Step) + 2;
+
+  m_Values.resize(numNodes);
+  m_ScaledDerivatives.resize(numNodes);
+
+  // The first node is never used for interpolation
+  m_Values[0] = 1.0;
+  m_ScaledDerivatives[0] = 0.0;
+
+  for (unsigned int i = 1;i < numNodes;++i)
+  {
+    double x = (double)i * m_Step;
+    m_Values[i] = GetExactValue(x, m_Smoothness);
+    m_ScaledDerivatives[i] = m_Step * GetExactDerivative(x, m_Smoothness);
+  }
+}
+
+double MaternCorrelationTable::Evaluate(const double x) const
+{
+  if (x >= m_Cutoff)
+    return 0.0;
+
+  if (x < m_Step || x < m_ExactThreshold)
+    return GetExactValue(x, m_Smoothness);
+
+  return this->GetInterpolatedValue(x);
+}
+
+double MaternCorrelationTable::EvaluateDerivative(const double x) const
+{
+  if (x >= m_Cutoff)
+    return 0.0;
+
+  if (x < m_Step || x < m_ExactThreshold)
+    return GetExactDerivative(x, m_Smoothness);
+
+  double workPosition = x * m_InverseStep;
+  unsigned int pos = (unsigned int)workPosition;
+  double t = workPosition - (double)pos;
+  double t2 = t * t;
+
+  double resVal = (6.0 * t2 - 6.0 * t) * m_Values[pos];
+  resVal += (3.0 * t2 - 4.0 * t + 1.0) * m_ScaledDerivatives[pos];
+  resVal += (6.0 * t - 6.0 * t2) * m_Values[pos + 1];
+  resVal += (3.0 * t2 - 2.0 * t) * m_ScaledDerivatives[pos + 1];
+
+  return resVal * m_InverseStep;
+}
+
+double MaternCorrelationTable::GetInterpolatedValue(const double x) const
+{
+  double workPosition = x * m_InverseStep;
+  unsigned int pos = (unsigned int)workPosition;
+  double t = workPosition - (double)pos;
+  double t2 = t * t;
+  double t3 = t2 * t;
+
+  double resVal = (2.0 * t3 - 3.0 * t2 + 1.0) * m_Values[pos];
+  resVal += (t3 - 2.0 * t2 + t) * m_ScaledDerivatives[pos];
+  resVal += (3.0 * t2 - 2.0 * t3) * m_Values[pos + 1];
+  resVal += (t3 - t2) * m_ScaledDerivatives[pos + 1];
+
+  return resVal;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <RcppEnsmallen.h>
+
+//! Lookup table for the Matern correlation function
+//! M(u) = 2^(1 - nu) / Gamma(nu) u^nu K_nu(u), which equals 1 at the origin
+//! and decays exponentially. It is tabulated on a uniform grid with its
+//! derivative -2^(1 - nu) / Gamma(nu) u^nu K_(nu - 1)(u) and evaluated by
+//! cubic Hermite interpolation. The grid step is halved until the error at
+//! the midpoints meets the requested absolute accuracy; beyond the cutoff
+//! where M(u) falls below it, the table returns 0. M behaves like
+//! 1 - c u^(2 nu) at the origin so that, for small nu, values below a fixed
+//! threshold are evaluated exactly instead.
+//!
+//! K_nu(u) overflows near the origin for large nu, e.g. below u = 2.5e-5 for
+//! nu = 50, while u^nu K_nu(u) stays bounded. The exact values then come
+//! from the regular part of the expansion of M at the origin,
+//! sum_k Gamma(nu - k) / (Gamma(nu) k!) (-u^2 / 4)^k, whose singular
+//! counterpart of order u^(2 nu) is negligible there. The series converges
+//! quickly as long as the threshold stays small against sqrt(nu), that is
+//! for nu up to a few hundreds.
+class MaternCorrelationTable
+{
+public:
+  MaternCorrelationTable()
+  {
+    m_Smoothness = NA_REAL;
+    m_Tolerance = NA_REAL;
+    m_Step = 0.0;
+    m_InverseStep = 0.0;
+    m_Cutoff = 0.0;
+    m_ExactThreshold = 0.0;
+  }
+
+  ~MaternCorrelationTable() {}
+
+  void Build(const double smoothness, const double tolerance);
+  bool IsBuilt() const {return !m_Values.empty();}
+  void Clear();
+  double Evaluate(const double x) const;
+  double EvaluateDerivative(const double x) const;
+  double GetSmoothness() const {return m_Smoothness;}
+  double GetTolerance() const {return m_Tolerance;}
+  double GetCutoff() const {return m_Cutoff;}
+  unsigned int GetNumberOfNodes() const {return m_Values.size();}
+
+  //! Reference value computed with boost::math::cyl_bessel_k(), or with the
+  //! series at the origin below GetSeriesThreshold()
+  static double GetExactValue(const double x, const double smoothness);
+  static double GetExactDerivative(const double x, const double smoothness);
+
+  //! Argument below which K_nu may overflow
+  static double GetSeriesThreshold(const double smoothness);
+
+private:
+  static double GetSeriesValue(const double x, const double smoothness, double *derivative = NULL);
+
+  void SetNodes(const double step);
+  double GetInterpolatedValue(const double x) const;
+
+  double m_Smoothness, m_Tolerance;
+  double m_Step, m_InverseStep;
+  double m_Cutoff, m_ExactThreshold;
+  std::vector<double> m_Values, m_ScaledDerivatives;
+
+  static const unsigned int m_MaximalNumberOfNodes;
+  static const double m_SmoothnessThreshold;
+  static const double m_OverflowMargin;
+};
@@ -0,0 +1,140 @@
+#include <RcppEnsmallen.h>
+#include "maternLogLikelihood.h"
+#include "maternCorrelationTable.h"
+
+// [[Rcpp::export]]
+double EvaluateMatern(
+    const arma::vec &p,
+    const arma::mat &X,
+    const arma::uvec &labels,
+    const arma::vec &lb,
+    const arma::vec &ub,
+    const double rho1 = NA_REAL,
+    const double rho2 = NA_REAL,
+    const double nu = 10.0,
+    const double interpolation_tolerance = 0.0,
+    const unsigned int num_threads = 1,
+    const double sparse_tolerance = 0.0,
+    const unsigned int num_probes = 0,
+    const bool single_precision = false,
+    const unsigned int num_correction_probes = 16)
+{
+  // Construct the objective function.
+  MaternLogLikelihood logLik;
+  logLik.SetSmoothness(nu);
+  logLik.SetInterpolationTolerance(interpolation_tolerance);
+  logLik.SetNumberOfThreads(num_threads);
+  logLik.SetSparseTolerance(sparse_tolerance);
+  logLik.SetNumberOfProbes(num_probes);
+  logLik.SetSinglePrecision(single_precision);
+  logLik.SetNumberOfCorrectionProbes(num_correction_probes);
+  logLik.SetInputs(X, labels, lb, ub);
+
+  if (arma::is_finite(rho1) & arma::is_finite(rho2))
+    logLik.SetIntensities(rho1, rho2);
+
+  arma::mat params(p.n_elem, 1);
+  for (unsigned int i = 0;i < p.n_elem;++i)
+    params[i] = p[i];
+
+  double resVal = logLik.Evaluate(params);
+  logLik.WarnCappedLFunctions();
+
+  return resVal;
+}
+
+// [[Rcpp::export]]
+SEXP CreateMaternLogLikelihood(
+    const arma::mat &X,
+    const arma::uvec &labels,
+    const arma::vec &lb,
+    const arma::vec &ub,
+    const double rho1 = NA_REAL,
+    const double rho2 = NA_REAL,
+    const double nu = 10.0,
+    const double interpolation_tolerance = 0.0,
+    const unsigned int num_threads = 1,
+    const double sparse_tolerance = 0.0,
+    const unsigned int num_probes = 0,
+    const bool single_precision = false,
+    const unsigned int num_correction_probes = 16,
+    const bool profile = false)
+{
+  // Construct the objective function once so that the distances and the
+  // correlation table are shared by all subsequent evaluations.
+  MaternLogLikelihood *logLik = new MaternLogLikelihood;
+  Rcpp::XPtr<BaseLogLikelihood> logLikPtr(logLik, true);
+  logLik->SetSmoothness(nu);
+  logLik->SetInterpolationTolerance(interpolation_tolerance);
+  logLik->SetNumberOfThreads(num_threads);
+  logLik->SetSparseTolerance(sparse_tolerance);
+  logLik->SetNumberOfProbes(num_probes);
+  logLik->SetSinglePrecision(single_precision);
+  logLik->SetNumberOfCorrectionProbes(num_correction_probes);
+  logLik->SetProfiling(profile);
+  logLik->SetInputs(X, labels, lb, ub);
+
+  if (arma::is_finite(rho1) & arma::is_finite(rho2))
+    logLik->SetIntensities(rho1, rho2);
+
+  return logLikPtr;
+}
+
+// [[Rcpp::export]]
+arma::mat InitializeMatern(
+    const arma::mat &X,
+    const arma::uvec &labels,
+    const arma::vec &lb,
+    const arma::vec &ub,
+    const double rho1 = NA_REAL,
+    const double rho2 = NA_REAL,
+    const double alpha1 = NA_REAL,
+    const double alpha2 = NA_REAL,
+    const bool estimate_alpha = true)
+{
+  // Construct the objective function.
+  MaternLogLikelihood logLik;
+  logLik.SetInputs(X, labels, lb, ub);
+
+  if (arma::is_finite(rho1) & arma::is_finite(rho2))
+    logLik.SetIntensities(rho1, rho2);
+
+  return logLik.GetInitialPoint();
+}
+
+// [[Rcpp::export]]
+Rcpp::List CompareMaternCorrelation(
+    const arma::vec &x,
+    const double nu = 10.0,
+    const double tolerance = 1.0e-10)
+{
+  // Accuracy and speed of the lookup table against boost on the given
+  // arguments of the Matern correlation function.
+  unsigned int numValues = x.n_elem;
+  arma::vec exactValues(numValues), tableValues(numValues);
+
+  arma::wall_clock clock;
+  clock.tic();
+  MaternCorrelationTable table;
+  table.Build(nu, tolerance);
+  double buildTime = clock.toc();
+
+  clock.tic();
+  for (unsigned int i = 0;i < numValues;++i)
+    exactValues[i] = MaternCorrelationTable::GetExactValue(x[i], nu);
+  double exactTime = clock.toc();
+
+  clock.tic();
+  for (unsigned int i = 0;i < numValues;++i)
+    tableValues[i] = table.Evaluate(x[i]);
+  double tableTime = clock.toc();
+
+  return Rcpp::List::create(
+    Rcpp::Named("max_error") = arma::max(arma::abs(tableValues - exactValues)),
+    Rcpp::Named("exact_time") = exactTime,
+    Rcpp::Named("table_time") = tableTime,
+    Rcpp::Named("build_time") = buildTime,
+    Rcpp::Named("number_of_nodes") = table.GetNumberOfNodes(),
+    Rcpp::Named("cutoff") = table.GetCutoff()
+  );
+}
@@ -0,0 +1,171 @@
+#include "maternLogLikelihood.h"
+#include <boost/math/special_functions/gamma.hpp>
+
+void MaternLogLikelihood::SetSmoothness(const double x)
+{
+  m_Smoothness = x;
+  this->BuildCorrelationTable();
+  this->InitializeKernel();
+  this->ClearCache();
+}
+
+void MaternLogLikelihood::SetInterpolationTolerance(const double x)
+{
+  m_InterpolationTolerance = (arma::is_finite(x)) ? x : 0.0;
+  this->BuildCorrelationTable();
+  this->ClearCache();
+}
+
+void MaternLogLikelihood::BuildCorrelationTable()
+{
+  if (m_InterpolationTolerance > 0.0)
+    m_CorrelationTable.Build(m_Smoothness, m_InterpolationTolerance);
+  else
+    m_CorrelationTable.Clear();
+}
+
+void MaternLogLikelihood::InitializeKernel()
+{
+  unsigned int dimension = this->GetDomainDimension();
+  m_LogGammaRatio = this->GetLogGammaRatio(dimension);
+  m_InverseGammaRatio = std::exp(-m_LogGammaRatio);
+  KernelLogLikelihood<MaternLogLikelihood>::InitializeKernel();
+}
+
+double MaternLogLikelihood::GetLogGammaRatio(const unsigned int dimension)
+{
+  double order = (double)dimension / 2.0;
+  return boost::math::lgamma(m_Smoothness + order) - boost::math::lgamma(m_Smoothness);
+}
+
+double MaternLogLikelihood::GetFourierKernel(const double radius, const double alpha, const unsigned int dimension, const bool cross, double &derivative) const
+{
+  // if cross is true, alpha is its inverse
+  double exponentValue = m_Smoothness + (double)dimension / 2.0;
+  double sqRadius = 4.0 * M_PI * M_PI * radius * radius;
+  double sqAlpha = (cross) ? 1.0 / (alpha * alpha) : alpha * alpha;
+  double baseValue = 1.0 + sqRadius * sqAlpha;
+  double resVal = std::pow(baseValue, -exponentValue);
+
+  // d/dalpha of alpha^2 is 2 alpha and d/dbeta of 1 / beta^2 is -2 / beta^3
+  double derivSqAlpha = (cross) ? -2.0 * sqAlpha / alpha : 2.0 * alpha;
+  derivative = -exponentValue * sqRadius * derivSqAlpha / baseValue * resVal;
+  return resVal;
+}
+
+void MaternLogLikelihood::IntegrateSpectralDensity(double &value, arma::vec &gradient)
+{
+  this->IntegrateFourierKernel<MaternLogLikelihood>(value, gradient);
+}
+
+double MaternLogLikelihood::GetCrossAlphaLowerBound()
+{
+  return std::max(this->GetFirstAlpha(), this->GetSecondAlpha());
+}
+
+void MaternLogLikelihood::GetCrossAlphaLowerBoundDerivatives(double &firstDerivative, double &secondDerivative)
+{
+  // Symmetric subgradient when both alphas are equal
+  double firstAlpha = this->GetFirstAlpha();
+  double secondAlpha = this->GetSecondAlpha();
+
+  if (firstAlpha > secondAlpha)
+    firstDerivative = 1.0;
+  else if (firstAlpha < secondAlpha)
+    firstDerivative = 0.0;
+  else
+    firstDerivative = 0.5;
+
+  secondDerivative = 1.0 - firstDerivative;
+}
+
+void MaternLogLikelihood::GetCorrelation(const double x, double &value, double &derivative)
+{
+  if (m_CorrelationTable.IsBuilt())
+  {
+    value = m_CorrelationTable.Evaluate(x);
+    derivative = m_CorrelationTable.EvaluateDerivative(x);
+    return;
+  }
+
+  value = MaternCorrelationTable::GetExactValue(x, m_Smoothness);
+  derivative = (x > 0.0) ? MaternCorrelationTable::GetExactDerivative(x, m_Smoothness) : 0.0;
+}
+
+template <unsigned int TDimension>
+double MaternLogLikelihood::EvaluateKernel(const double sqDist, const double alpha, const bool cross)
+{
+  // if cross is true, alpha is its inverse
+  double inverseAlpha = (cross) ? alpha : 1.0 / alpha;
+  double firstTerm = DimensionTraits<TDimension>::GetHalfPower(inverseAlpha * inverseAlpha / (4.0 * M_PI)) * m_InverseGammaRatio;
+  double workValue = std::sqrt(sqDist) * inverseAlpha;
+
+  if (m_CorrelationTable.IsBuilt())
+    return firstTerm * m_CorrelationTable.Evaluate(workValue);
+
+  return firstTerm * MaternCorrelationTable::GetExactValue(workValue, m_Smoothness);
+}
+
+template <unsigned int TDimension>
+double MaternLogLikelihood::EvaluateKernelDerivative(const double sqDist, const double alpha, const bool cross)
+{
+  double inverseAlpha = (cross) ? alpha : 1.0 / alpha;
+  double firstTerm = DimensionTraits<TDimension>::GetHalfPower(inverseAlpha * inverseAlpha / (4.0 * M_PI)) * m_InverseGammaRatio;
+  double workValue = std::sqrt(sqDist) * inverseAlpha;
+  double correlationValue = 0.0, correlationDerivative = 0.0;
+  this->GetCorrelation(workValue, correlationValue, correlationDerivative);
+
+  double signValue = (cross) ? 1.0 : -1.0;
+  double resVal = (double)TDimension * correlationValue + workValue * correlationDerivative;
+  return signValue * firstTerm * resVal / alpha;
+}
+
+double MaternLogLikelihood::EvaluateGenericKernel(const double sqDist, const double alpha, const bool cross)
+{
+  // if cross is true, alpha is its inverse. The kernel is the Matern
+  // correlation divided by the amplitude per unit intensity
+  // (4 pi)^(d / 2) alpha^d Gamma(nu + d / 2) / Gamma(nu).
+  double inverseAlpha = (cross) ? alpha : 1.0 / alpha;
+  double order = (double)this->GetDomainDimension() / 2.0;
+  double logValue = order * std::log(inverseAlpha * inverseAlpha / (4.0 * M_PI)) - m_LogGammaRatio;
+  double workValue = std::sqrt(sqDist) * inverseAlpha;
+
+  if (m_CorrelationTable.IsBuilt())
+    return std::exp(logValue) * m_CorrelationTable.Evaluate(workValue);
+
+  return std::exp(logValue) * MaternCorrelationTable::GetExactValue(workValue, m_Smoothness);
+}
+
+double MaternLogLikelihood::EvaluateGenericKernelDerivative(const double sqDist, const double alpha, const bool cross)
+{
+  // Both the normalization and the argument of the correlation depend on
+  // alpha, or on its inverse if cross is true
+  unsigned int dimension = this->GetDomainDimension();
+  double inverseAlpha = (cross) ? alpha : 1.0 / alpha;
+  double order = (double)dimension / 2.0;
+  double logValue = order * std::log(inverseAlpha * inverseAlpha / (4.0 * M_PI)) - m_LogGammaRatio;
+  double workValue = std::sqrt(sqDist) * inverseAlpha;
+  double correlationValue = 0.0, correlationDerivative = 0.0;
+  this->GetCorrelation(workValue, correlationValue, correlationDerivative);
+
+  double signValue = (cross) ? 1.0 : -1.0;
+  double resVal = (double)dimension * correlationValue + workValue * correlationDerivative;
+  return signValue * std::exp(logValue) * resVal / alpha;
+}
+
+double MaternLogLikelihood::RetrieveIntensityFromParameters(const double amplitude, const double alpha, const unsigned int dimension)
+{
+  return amplitude / this->RetrieveAmplitudeFromParameters(1.0, alpha, dimension);
+}
+
+double MaternLogLikelihood::RetrieveAlphaFromParameters(const double amplitude, const double intensity, const unsigned int dimension)
+{
+  double logValue = std::log(amplitude / intensity) - this->GetLogGammaRatio(dimension);
+  return std::exp(logValue / (double)dimension) / std::sqrt(4.0 * M_PI);
+}
+
+double MaternLogLikelihood::RetrieveAmplitudeFromParameters(const double intensity, const double alpha, const unsigned int dimension)
+{
+  double order = (double)dimension / 2.0;
+  return intensity * std::exp(order * std::log(4.0 * M_PI * alpha * alpha) + this->GetLogGammaRatio(dimension));
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "kernelLogLikelihood.h"
+#include "maternCorrelationTable.h"
+
+class MaternLogLikelihood : public KernelLogLikelihood<MaternLogLikelihood>
+{
+public:
+  MaternLogLikelihood()
+  {
+    m_Smoothness = 10.0;
+    m_InterpolationTolerance = 0.0;
+    m_LogGammaRatio = 0.0;
+    m_InverseGammaRatio = 1.0;
+  }
+
+  double GetFourierKernel(
+      const double radius,
+      const double alpha,
+      const unsigned int dimension,
+      const bool cross,
+      double &derivative
+  ) const;
+
+  //! Smoothness parameter nu shared by the marginal and cross kernels
+  void SetSmoothness(const double x);
+  double GetSmoothness() {return m_Smoothness;}
+
+  //! Use a lookup table with the given absolute accuracy instead of boost for
+  //! evaluating the Matern correlation. A non-positive tolerance disables it.
+  void SetInterpolationTolerance(const double x);
+
+  double RetrieveIntensityFromParameters(const double amplitude, const double alpha, const unsigned int dimension);
+  double RetrieveAlphaFromParameters(const double amplitude, const double intensity, const unsigned int dimension);
+  double RetrieveAmplitudeFromParameters(const double intensity, const double alpha, const unsigned int dimension);
+
+private:
+  friend class KernelLogLikelihood<MaternLogLikelihood>;
+
+  template <unsigned int TDimension>
+  double EvaluateKernel(const double sqDist, const double alpha, const bool cross);
+  template <unsigned int TDimension>
+  double EvaluateKernelDerivative(const double sqDist, const double alpha, const bool cross);
+
+  //! Kernels for any dimension
+  double EvaluateGenericKernel(const double sqDist, const double alpha, const bool cross);
+  double EvaluateGenericKernelDerivative(const double sqDist, const double alpha, const bool cross);
+
+  //! Correlation and its derivative w.r.t. the scaled distance
+  void GetCorrelation(const double x, double &value, double &derivative);
+
+  double GetCrossAlphaLowerBound();
+  void GetCrossAlphaLowerBoundDerivatives(double &firstDerivative, double &secondDerivative);
+  void IntegrateSpectralDensity(double &value, arma::vec &gradient);
+  //! Gamma ratio of the domain dimension, then selection of the kernels
+  void InitializeKernel();
+  void BuildCorrelationTable();
+
+  //! log(Gamma(nu + d / 2) / Gamma(nu)) for the current domain dimension
+  double GetLogGammaRatio(const unsigned int dimension);
+
+  double m_Smoothness;
+  double m_InterpolationTolerance;
+  double m_LogGammaRatio, m_InverseGammaRatio;
+  MaternCorrelationTable m_CorrelationTable;
+};
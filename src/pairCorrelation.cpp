@@ -0,0 +1,167 @@
+#include <RcppEnsmallen.h>
+#include "besselJRatioTable.h"
+#include "pairCorrelationEstimator.h"
+#include <boost/math/special_functions/gamma.hpp>
+
+//' Pair Correlation Functions of Bivariate Point Patterns
+//'
+//' This function estimates the marginal and cross pair correlation functions
+//' of a bivariate point pattern observed in a rectangular domain with the
+//' Epanechnikov kernel and the translation edge correction. All three
+//' functions are computed in a single pass over the pairs of points closer
+//' than the largest radius plus the kernel support, found with a cell list.
+//'
+//' @param X A matrix of size n x d storing the points in R^d.
+//' @param labels A vector of size n storing the labels (1 or 2) of the points.
+//' @param lb A d-dimensional vector storing the lower bounds of the domain.
+//' @param ub A d-dimensional vector storing the upper bounds of the domain.
+//' @param rmin Smallest radius (default: 0).
+//' @param rmax Largest radius. If `NA` (default), it is a quarter of the
+//'   shortest side of the domain.
+//' @param nr Number of equally spaced radii (default: 513).
+//' @param bw Standard deviation of the kernel. If `NA` (default), it is
+//'   `0.15 / sqrt(5)` times the mean distance `lambda^(-1/d)` between the
+//'   points involved in each function, following Stoyan's rule.
+//' @param divisor Either `"r"` (default, as in [spatstat::pcf()]) to divide the
+//'   kernel contributions by the area of the sphere at the radius, or `"d"` to
+//'   divide them by its area at the pair distance.
+//'
+//' @return A list with the vector `r` of the radii and the vectors `g11`,
+//'   `g22` and `g12` of the estimated pair correlation functions.
+//'
+//' @export
+// [[Rcpp::export]]
+Rcpp::List EstimatePairCorrelation(
+    const arma::mat &X,
+    const arma::uvec &labels,
+    const arma::vec &lb,
+    const arma::vec &ub,
+    const double rmin = 0.0,
+    const double rmax = NA_REAL,
+    const unsigned int nr = 513,
+    const double bw = NA_REAL,
+    const std::string divisor = "r")
+{
+  if (X.n_cols != lb.n_elem || lb.n_elem != ub.n_elem)
+    Rcpp::stop("The points and the domain bounds should have the same dimension.");
+
+  if (divisor != "d" && divisor != "r")
+    Rcpp::stop("The divisor should be either d or r.");
+
+  arma::vec boxLengths = ub - lb;
+  double domainVolume = arma::prod(boxLengths);
+  double dimension = (double)X.n_cols;
+
+  double workRmax = rmax;
+  if (!arma::is_finite(workRmax))
+    workRmax = boxLengths.min() / 4.0;
+
+  arma::vec bandwidths(3);
+  if (arma::is_finite(bw))
+    bandwidths.fill(bw);
+  else
+  {
+    double firstIntensity = (double)arma::accu(labels == 1) / domainVolume;
+    double secondIntensity = (double)arma::accu(labels == 2) / domainVolume;
+    bandwidths[0] = 0.15 / std::sqrt(5.0) * std::pow(firstIntensity, -1.0 / dimension);
+    bandwidths[1] = 0.15 / std::sqrt(5.0) * std::pow(secondIntensity, -1.0 / dimension);
+    bandwidths[2] = 0.15 / std::sqrt(5.0) * std::pow(firstIntensity + secondIntensity, -1.0 / dimension);
+  }
+
+  PairCorrelationEstimator estimator;
+  estimator.SetDomain(lb, ub);
+  estimator.SetBandwidths(bandwidths);
+  estimator.SetUseDistanceDivisor(divisor == "d");
+
+  try
+  {
+    estimator.SetRadii(rmin, workRmax, nr);
+    estimator.Compute(X, labels);
+  }
+  catch (std::exception &e)
+  {
+    Rcpp::stop(e.what());
+  }
+
+  const arma::mat &values = estimator.GetValues();
+
+  return Rcpp::List::create(
+    Rcpp::Named("r") = Rcpp::NumericVector(estimator.GetRadii().begin(), estimator.GetRadii().end()),
+    Rcpp::Named("g11") = Rcpp::NumericVector(values.begin_col(0), values.end_col(0)),
+    Rcpp::Named("g22") = Rcpp::NumericVector(values.begin_col(1), values.end_col(1)),
+    Rcpp::Named("g12") = Rcpp::NumericVector(values.begin_col(2), values.end_col(2))
+  );
+}
+
+//' Pair Correlation Functions of Bessel DPPs
+//'
+//' `GetBesselPCF()` evaluates the pair correlation function
+//' `1 - tau^2 M(r)^2` of a Bessel DPP, where `M` is the normalized Bessel
+//' kernel with parameter `alpha`, which is a marginal function if `tau = 1`
+//' and a cross function otherwise. `ComputeBesselPCFContrast()` computes the
+//' contrast `sum(abs(y^p - g(r)^p)^q)` between an estimated function `y` and
+//' the theoretical one `g`, so that minimum contrast fits only call compiled
+//' code.
+//'
+//' @param r A vector of radii.
+//' @param alpha Alpha parameter of the kernel.
+//' @param tau Correlation between both types of points (default: 1).
+//' @param d Dimension of the space (default: 2).
+//'
+//' @return `GetBesselPCF()` returns the vector of the values at `r`.
+//'   `ComputeBesselPCFContrast()` returns the contrast value.
+//'
+//' @export
+// [[Rcpp::export]]
+arma::vec GetBesselPCF(
+    const arma::vec &r,
+    const double alpha,
+    const double tau = 1.0,
+    const unsigned int d = 2)
+{
+  double order = (double)d / 2.0;
+  double gammaValue = boost::math::tgamma(1.0 + order);
+  double argumentFactor = std::sqrt(2.0 * (double)d) / alpha;
+  arma::vec resVec(r.n_elem);
+
+  for (unsigned int k = 0;k < r.n_elem;++k)
+  {
+    double kernelValue = gammaValue * BesselJRatioTable::GetExactValue(argumentFactor * r[k], order);
+    resVec[k] = 1.0 - tau * tau * kernelValue * kernelValue;
+  }
+
+  return resVec;
+}
+
+//' @rdname GetBesselPCF
+//'
+//' @param y A vector of estimated values of the pair correlation function
+//'   at `r`.
+//' @param p Power applied to both functions (default: 0.5).
+//' @param q Power applied to their absolute differences (default: 2).
+//'
+//' @export
+// [[Rcpp::export]]
+double ComputeBesselPCFContrast(
+    const arma::vec &y,
+    const arma::vec &r,
+    const double alpha,
+    const double tau = 1.0,
+    const unsigned int d = 2,
+    const double p = 0.5,
+    const double q = 2.0)
+{
+  if (y.n_elem != r.n_elem)
+    Rcpp::stop("The estimated values and the radii should have the same length.");
+
+  arma::vec theoreticalValues = GetBesselPCF(r, alpha, tau, d);
+  double resVal = 0.0;
+
+  for (unsigned int k = 0;k < r.n_elem;++k)
+  {
+    double workValue = std::abs(std::pow(y[k], p) - std::pow(theoreticalValues[k], p));
+    resVal += (q == 2.0) ? workValue * workValue : std::pow(workValue, q);
+  }
+
+  return resVal;
+}
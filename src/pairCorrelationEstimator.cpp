@@ -0,0 +1,121 @@
+#include "pairCorrelationEstimator.h"
+#include "cellList.h"
+#include <boost/math/special_functions/gamma.hpp>
+#include <stdexcept>
+
+void PairCorrelationEstimator::SetDomain(const arma::vec &lb, const arma::vec &ub)
+{
+  m_LowerBounds = lb;
+  m_BoxLengths = ub - lb;
+}
+
+void PairCorrelationEstimator::SetRadii(const double rmin, const double rmax, const unsigned int n)
+{
+  if (n < 2 || rmin < 0.0 || rmax <= rmin)
+    throw std::invalid_argument("The grid of radii should have at least two increasing non-negative values.");
+
+  m_Radii = arma::linspace(rmin, rmax, n);
+}
+
+void PairCorrelationEstimator::AddPair(const unsigned int column, const double distance, const double weight)
+{
+  // Epanechnikov kernel 3 / (4 w) (1 - u^2 / w^2) on [-w, w], w = sqrt(5) h
+  unsigned int numRadii = m_Radii.n_elem;
+  double halfWidth = std::sqrt(5.0) * m_Bandwidths[column];
+  double radiusStep = (m_Radii[numRadii - 1] - m_Radii[0]) / (double)(numRadii - 1);
+  double firstValue = std::ceil((distance - halfWidth - m_Radii[0]) / radiusStep);
+  double lastValue = std::floor((distance + halfWidth - m_Radii[0]) / radiusStep);
+
+  if (lastValue < 0.0 || firstValue > (double)(numRadii - 1))
+    return;
+
+  unsigned int firstIndex = (unsigned int)std::max(firstValue, 0.0);
+  unsigned int lastIndex = (unsigned int)std::min(lastValue, (double)(numRadii - 1));
+  double kernelFactor = 0.75 * weight / halfWidth;
+  double *workValues = m_Values.colptr(column);
+
+  for (unsigned int k = firstIndex;k <= lastIndex;++k)
+  {
+    double workValue = (m_Radii[k] - distance) / halfWidth;
+
+    if (workValue * workValue < 1.0)
+      workValues[k] += kernelFactor * (1.0 - workValue * workValue);
+  }
+}
+
+void PairCorrelationEstimator::Compute(const arma::mat &points, const arma::uvec &labels)
+{
+  unsigned int dimension = m_BoxLengths.n_elem;
+  unsigned int numRadii = m_Radii.n_elem;
+
+  if (numRadii == 0 || m_Bandwidths.n_elem != 3)
+    throw std::invalid_argument("The radii and the three bandwidths should be set before computing the pair correlation functions.");
+
+  if (labels.n_elem != points.n_rows)
+    throw std::invalid_argument("There should be as many labels as points.");
+
+  if (labels.n_elem > 0 && (labels.min() < 1 || labels.max() > 2))
+    throw std::invalid_argument("The labels should be either 1 or 2.");
+
+  double maximalDistance = m_Radii[numRadii - 1] + std::sqrt(5.0) * m_Bandwidths.max();
+  double domainVolume = arma::prod(m_BoxLengths);
+
+  CellList cellList;
+  cellList.SetDomain(m_LowerBounds, m_LowerBounds + m_BoxLengths);
+  cellList.Build(points, maximalDistance);
+
+  m_Values.zeros(numRadii, 3);
+
+  auto pairFunction = [&](const unsigned int i, const unsigned int j, const std::vector<double> &difference)
+  {
+    double sqDist = 0.0, edgeValue = 1.0;
+    for (unsigned int l = 0;l < dimension;++l)
+    {
+      sqDist += difference[l] * difference[l];
+      edgeValue *= m_BoxLengths[l] - difference[l];
+    }
+
+    double distance = std::sqrt(sqDist);
+    double weight = 1.0 / edgeValue;
+
+    if (m_UseDistanceDivisor)
+    {
+      // Duplicated points do not contribute
+      if (distance == 0.0)
+        return;
+
+      weight /= std::pow(distance, (double)dimension - 1.0);
+    }
+
+    // Column 0 for 1-1 pairs, 1 for 2-2 pairs and 2 for mixed pairs
+    unsigned int column = (labels[i] == labels[j]) ? labels[i] - 1 : 2;
+    this->AddPair(column, distance, weight);
+  };
+
+  cellList.VisitPairs(points, pairFunction);
+
+  // Marginal pairs are counted once instead of twice.
+  double firstCount = (double)arma::accu(labels == 1);
+  double secondCount = (double)arma::accu(labels == 2);
+  double sphereArea = 2.0 * std::pow(M_PI, (double)dimension / 2.0) / boost::math::tgamma((double)dimension / 2.0);
+  double normFactors[3] = {
+    2.0 / (firstCount * (firstCount - 1.0)),
+    2.0 / (secondCount * (secondCount - 1.0)),
+    1.0 / (firstCount * secondCount)
+  };
+
+  for (unsigned int c = 0;c < 3;++c)
+  {
+    double *workValues = m_Values.colptr(c);
+
+    for (unsigned int k = 0;k < numRadii;++k)
+    {
+      double workValue = domainVolume * domainVolume * normFactors[c] / sphereArea;
+
+      if (!m_UseDistanceDivisor)
+        workValue /= std::pow(m_Radii[k], (double)dimension - 1.0);
+
+      workValues[k] *= workValue;
+    }
+  }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <RcppEnsmallen.h>
+
+//! Kernel estimator of the marginal and cross pair correlation functions of
+//! a bivariate point pattern observed in a rectangular domain W. On a uniform
+//! grid of radii r_k, the function of types a and b is estimated by
+//!
+//!   g_ab(r) = V^2 / (n_ab s_d r^(d - 1)) sum k_h(r - |x_i - x_j|) / |W n W_(x_i - x_j)|
+//!
+//! where the sum runs over the ordered pairs of distinct points of types a
+//! and b, n_ab is n_a (n_a - 1) or n_a n_b, s_d is the area of the unit
+//! sphere, k_h is the Epanechnikov kernel with standard deviation h and the
+//! translation edge correction |W n W_u| = prod (L_l - |u_l|) is exact for
+//! rectangles. All three functions are accumulated in a single pass over the
+//! pairs found by a cell list.
+class PairCorrelationEstimator
+{
+public:
+  PairCorrelationEstimator()
+  {
+    m_UseDistanceDivisor = true;
+  }
+
+  ~PairCorrelationEstimator() {}
+
+  void SetDomain(const arma::vec &lb, const arma::vec &ub);
+
+  //! Uniform grid of n radii from rmin to rmax
+  void SetRadii(const double rmin, const double rmax, const unsigned int n);
+
+  //! Standard deviations of the kernels of g11, g22 and g12
+  void SetBandwidths(const arma::vec &x) {m_Bandwidths = x;}
+
+  //! If true (default), the sphere area is evaluated at the pair distance
+  //! instead of the radius, which avoids the singularity at r = 0
+  void SetUseDistanceDivisor(const bool x) {m_UseDistanceDivisor = x;}
+
+  //! Points are given row-wise with labels 1 or 2
+  void Compute(const arma::mat &points, const arma::uvec &labels);
+
+  const arma::vec &GetRadii() const {return m_Radii;}
+
+  //! Columns g11, g22 and g12 evaluated at the radii
+  const arma::mat &GetValues() const {return m_Values;}
+
+private:
+  //! Adds the kernel contributions of one pair at the given distance
+  void AddPair(const unsigned int column, const double distance, const double weight);
+
+  arma::vec m_LowerBounds, m_BoxLengths;
+  arma::vec m_Radii, m_Bandwidths;
+  arma::mat m_Values;
+  bool m_UseDistanceDivisor;
+};
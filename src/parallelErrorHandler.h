@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+//! Error raised within the iterations of an OpenMP loop. An exception which
+//! escapes a parallel region terminates the program instead of reaching R,
+//! so that loop bodies store it with Store() and the loop is followed by
+//! Rethrow(). The error of the lowest iteration is kept so that the message
+//! does not depend on the number of threads.
+class ParallelErrorHandler
+{
+public:
+  ParallelErrorHandler()
+  {
+    m_HasError = false;
+    m_Index = 0;
+  }
+
+  ~ParallelErrorHandler() {}
+
+  void Store(const unsigned int index, const std::exception &e)
+  {
+#ifdef _OPENMP
+    #pragma omp critical(ParallelErrorHandler)
+#endif
+    {
+      if (!m_HasError || index < m_Index)
+      {
+        m_HasError = true;
+        m_Index = index;
+        m_Message = e.what();
+      }
+    }
+  }
+
+  bool HasError() const {return m_HasError;}
+
+  //! Throws the stored error as a std::runtime_error, if any, and resets it
+  void Rethrow()
+  {
+    if (!m_HasError)
+      return;
+
+    m_HasError = false;
+    throw std::runtime_error(m_Message);
+  }
+
+private:
+  bool m_HasError;
+  unsigned int m_Index;
+  std::string m_Message;
+};
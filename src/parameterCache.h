@@ -0,0 +1,82 @@
+#pragma once
+
+#include <RcppEnsmallen.h>
+#include <list>
+
+//! Least recently used cache of values computed for given parameter
+//! vectors. Keys are compared exactly, which suits optimizers such as
+//! Nelder-Mead or DIRECT that evaluate the very same points several times.
+//! A linear search is used since the cache is meant to stay small.
+template <class TValue>
+class ParameterCache
+{
+public:
+  ParameterCache()
+  {
+    m_MaximalSize = 16;
+  }
+
+  ~ParameterCache() {}
+
+  //! Zero disables the cache
+  void SetMaximalSize(const unsigned int n)
+  {
+    m_MaximalSize = n;
+    while (m_Entries.size() > m_MaximalSize)
+      m_Entries.pop_back();
+  }
+
+  unsigned int GetMaximalSize() const {return m_MaximalSize;}
+  unsigned int GetSize() const {return m_Entries.size();}
+  void Clear() {m_Entries.clear();}
+
+  //! Values stored for the key, which become the most recently used ones, or
+  //! NULL if there are none
+  TValue *Find(const arma::vec &key)
+  {
+    for (typename std::list<EntryType>::iterator it = m_Entries.begin();it != m_Entries.end();++it)
+    {
+      if (!this->IsEqual(it->first, key))
+        continue;
+
+      m_Entries.splice(m_Entries.begin(), m_Entries, it);
+      return &(m_Entries.front().second);
+    }
+
+    return NULL;
+  }
+
+  //! Values to be filled for a new key, evicting the least recently used
+  //! ones if the cache is full, or NULL if the cache is disabled
+  TValue *Insert(const arma::vec &key)
+  {
+    if (m_MaximalSize == 0)
+      return NULL;
+
+    if (m_Entries.size() == m_MaximalSize)
+      m_Entries.pop_back();
+
+    m_Entries.push_front(EntryType(key, TValue()));
+    return &(m_Entries.front().second);
+  }
+
+private:
+  typedef std::pair<arma::vec, TValue> EntryType;
+
+  bool IsEqual(const arma::vec &firstKey, const arma::vec &secondKey) const
+  {
+    if (firstKey.n_elem != secondKey.n_elem)
+      return false;
+
+    for (unsigned int i = 0;i < firstKey.n_elem;++i)
+    {
+      if (firstKey[i] != secondKey[i])
+        return false;
+    }
+
+    return true;
+  }
+
+  std::list<EntryType> m_Entries;
+  unsigned int m_MaximalSize;
+};
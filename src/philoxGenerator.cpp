@@ -0,0 +1,52 @@
+#include "philoxGenerator.h"
+
+void PhiloxGenerator::SetSeed(const uint64_t seed, const uint64_t stream)
+{
+  m_Key[0] = (uint32_t)seed;
+  m_Key[1] = (uint32_t)(seed >> 32);
+  m_Counter[0] = 0;
+  m_Counter[1] = 0;
+  m_Counter[2] = (uint32_t)stream;
+  m_Counter[3] = (uint32_t)(stream >> 32);
+  m_Position = 4;
+}
+
+void PhiloxGenerator::GenerateBlock()
+{
+  const uint32_t firstMultiplier = 0xD2511F53;
+  const uint32_t secondMultiplier = 0xCD9E8D57;
+  const uint32_t firstKeyIncrement = 0x9E3779B9;
+  const uint32_t secondKeyIncrement = 0xBB67AE85;
+
+  uint32_t workKey[2] = {m_Key[0], m_Key[1]};
+  uint32_t workBlock[4] = {m_Counter[0], m_Counter[1], m_Counter[2], m_Counter[3]};
+
+  for (unsigned int i = 0;i < 10;++i)
+  {
+    if (i > 0)
+    {
+      workKey[0] += firstKeyIncrement;
+      workKey[1] += secondKeyIncrement;
+    }
+
+    uint64_t firstProduct = (uint64_t)firstMultiplier * workBlock[0];
+    uint64_t secondProduct = (uint64_t)secondMultiplier * workBlock[2];
+    uint32_t workValues[4] = {
+      (uint32_t)(secondProduct >> 32) ^ workBlock[1] ^ workKey[0],
+      (uint32_t)secondProduct,
+      (uint32_t)(firstProduct >> 32) ^ workBlock[3] ^ workKey[1],
+      (uint32_t)firstProduct
+    };
+
+    for (unsigned int j = 0;j < 4;++j)
+      workBlock[j] = workValues[j];
+  }
+
+  for (unsigned int j = 0;j < 4;++j)
+    m_Block[j] = workBlock[j];
+  m_Position = 0;
+
+  // The first half of the counter indexes the blocks of the stream.
+  if (++m_Counter[0] == 0)
+    ++m_Counter[1];
+}
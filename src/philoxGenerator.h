@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+
+//! Counter-based Philox4x32-10 generator (Salmon et al., 2011). The 64-bit
+//! seed is the key and each stream is a distinct half of the 128-bit
+//! counter, so that the numbers drawn in a stream only depend on the seed
+//! and the stream index. Streams can thus be used from any thread in any
+//! order with reproducible results.
+class PhiloxGenerator
+{
+public:
+  PhiloxGenerator(const uint64_t seed = 0, const uint64_t stream = 0)
+  {
+    this->SetSeed(seed, stream);
+  }
+
+  ~PhiloxGenerator() {}
+
+  void SetSeed(const uint64_t seed, const uint64_t stream);
+
+  //! Uniform number in [0, 1) with 53 random bits
+  double GetUniform()
+  {
+    if (m_Position == 4)
+      this->GenerateBlock();
+
+    uint32_t firstWord = m_Block[m_Position] >> 5;
+    uint32_t secondWord = m_Block[m_Position + 1] >> 6;
+    m_Position += 2;
+
+    return ((double)firstWord * 67108864.0 + (double)secondWord) / 9007199254740992.0;
+  }
+
+private:
+  //! Encrypts the counter into four new words and increments it
+  void GenerateBlock();
+
+  uint32_t m_Key[2];
+  uint32_t m_Counter[4];
+  uint32_t m_Block[4];
+  unsigned int m_Position;
+};
@@ -0,0 +1,283 @@
+#include "projectionSampler.h"
+#include <complex>
+#include <stdexcept>
+
+void ProjectionSampler::SetDomain(const arma::vec &lb, const arma::vec &boxLengths)
+{
+  m_LowerBounds = lb;
+  m_BoxLengths = boxLengths;
+}
+
+void ProjectionSampler::AddEigenPair(const std::vector<int> &frequency, const double firstCoordinate, const double secondCoordinate)
+{
+  m_Frequencies.insert(m_Frequencies.end(), frequency.begin(), frequency.end());
+  m_EigenVectors.push_back(firstCoordinate);
+  m_EigenVectors.push_back(secondCoordinate);
+}
+
+void ProjectionSampler::EvaluateBasisFunctions(const double *point, const unsigned int label, double *realValues, double *imagValues) const
+{
+  unsigned int dimension = m_BoxLengths.n_elem;
+  unsigned int numFrequencies = 2 * m_Truncation + 1;
+  unsigned int numPairs = m_EigenVectors.size() / 2;
+
+  // exp(2 i pi k x / L) for all integer k in [-N, N] by successive products
+  std::vector<std::complex<double> > powerValues(dimension * numFrequencies);
+  for (unsigned int l = 0;l < dimension;++l)
+  {
+    double angleValue = 2.0 * M_PI * point[l] / m_BoxLengths[l];
+    std::complex<double> unitValue(std::cos(angleValue), std::sin(angleValue));
+    std::complex<double> *workPowers = &(powerValues[l * numFrequencies + m_Truncation]);
+    workPowers[0] = 1.0;
+    for (unsigned int k = 1;k <= m_Truncation;++k)
+    {
+      workPowers[k] = workPowers[k - 1] * unitValue;
+      workPowers[-(int)k] = std::conj(workPowers[k]);
+    }
+  }
+
+  for (unsigned int j = 0;j < numPairs;++j)
+  {
+    std::complex<double> workValue = m_EigenVectors[2 * j + label];
+    for (unsigned int l = 0;l < dimension;++l)
+      workValue *= powerValues[l * numFrequencies + m_Truncation + m_Frequencies[j * dimension + l]];
+    realValues[j] = workValue.real();
+    imagValues[j] = workValue.imag();
+  }
+}
+
+void ProjectionSampler::ApplyReflectors(double *realValues, double *imagValues, const unsigned int firstReflector) const
+{
+  for (unsigned int j = firstReflector;j < m_NumberOfReflectors;++j)
+  {
+    unsigned int workDimension = m_BaseDimension - j;
+    const double *realVector = m_RealReflectors.memptr() + j * m_BaseDimension;
+    const double *imagVector = m_ImagReflectors.memptr() + j * m_BaseDimension;
+
+    double realProduct = 0.0, imagProduct = 0.0;
+    for (unsigned int k = 0;k < workDimension;++k)
+    {
+      realProduct += realVector[k] * realValues[k] + imagVector[k] * imagValues[k];
+      imagProduct += realVector[k] * imagValues[k] - imagVector[k] * realValues[k];
+    }
+
+    realProduct *= m_ReflectorFactors[j];
+    imagProduct *= m_ReflectorFactors[j];
+
+    for (unsigned int k = 0;k < workDimension;++k)
+    {
+      realValues[k] -= realVector[k] * realProduct - imagVector[k] * imagProduct;
+      imagValues[k] -= realVector[k] * imagProduct + imagVector[k] * realProduct;
+    }
+  }
+}
+
+void ProjectionSampler::AddReflector(const double *realValues, const double *imagValues)
+{
+  unsigned int workDimension = m_BaseDimension - m_NumberOfReflectors;
+  double *realVector = m_RealReflectors.memptr() + m_NumberOfReflectors * m_BaseDimension;
+  double *imagVector = m_ImagReflectors.memptr() + m_NumberOfReflectors * m_BaseDimension;
+
+  double sqNorm = 0.0;
+  for (unsigned int k = 0;k < m_BaseDimension;++k)
+  {
+    realVector[k] = (k < workDimension) ? realValues[k] : 0.0;
+    imagVector[k] = (k < workDimension) ? imagValues[k] : 0.0;
+    sqNorm += realVector[k] * realVector[k] + imagVector[k] * imagVector[k];
+  }
+
+  // u = c + |c| exp(i arg(c_m)) e_m, so that |u|^2 = 2 |c| (|c| + |c_m|)
+  double normValue = std::sqrt(sqNorm);
+  double lastModulus = std::sqrt(realVector[workDimension - 1] * realVector[workDimension - 1] + imagVector[workDimension - 1] * imagVector[workDimension - 1]);
+  double realPhase = (lastModulus > 0.0) ? realVector[workDimension - 1] / lastModulus : 1.0;
+  double imagPhase = (lastModulus > 0.0) ? imagVector[workDimension - 1] / lastModulus : 0.0;
+  realVector[workDimension - 1] += normValue * realPhase;
+  imagVector[workDimension - 1] += normValue * imagPhase;
+
+  m_ReflectorFactors[m_NumberOfReflectors] = 1.0 / (normValue * (normValue + lastModulus));
+  ++m_NumberOfReflectors;
+}
+
+void ProjectionSampler::MergeReflectors()
+{
+  unsigned int numPairs = m_RealComplement.n_rows;
+  unsigned int numReflectors = m_NumberOfReflectors;
+  unsigned int newDimension = m_BaseDimension - numReflectors;
+
+  arma::mat realBasis(m_RealComplement.memptr(), numPairs, m_BaseDimension, false, true);
+  arma::mat imagBasis(m_ImagComplement.memptr(), numPairs, m_BaseDimension, false, true);
+  arma::mat realVectors(m_RealReflectors.memptr(), m_BaseDimension, numReflectors, false, true);
+  arma::mat imagVectors(m_ImagReflectors.memptr(), m_BaseDimension, numReflectors, false, true);
+
+  // Upper triangular T by the forward recurrence
+  // T(0:j, j) = -t_j T(0:j, 0:j) U(:, 0:j)^H u_j
+  arma::mat realGram = realVectors.t() * realVectors + imagVectors.t() * imagVectors;
+  arma::mat imagGram = realVectors.t() * imagVectors - imagVectors.t() * realVectors;
+  arma::mat realFactors(numReflectors, numReflectors, arma::fill::zeros);
+  arma::mat imagFactors(numReflectors, numReflectors, arma::fill::zeros);
+
+  for (unsigned int j = 0;j < numReflectors;++j)
+  {
+    realFactors(j, j) = m_ReflectorFactors[j];
+
+    for (unsigned int k = 0;k < j;++k)
+    {
+      double realValue = 0.0, imagValue = 0.0;
+      for (unsigned int l = k;l < j;++l)
+      {
+        realValue += realFactors(k, l) * realGram(l, j) - imagFactors(k, l) * imagGram(l, j);
+        imagValue += realFactors(k, l) * imagGram(l, j) + imagFactors(k, l) * realGram(l, j);
+      }
+      realFactors(k, j) = -m_ReflectorFactors[j] * realValue;
+      imagFactors(k, j) = -m_ReflectorFactors[j] * imagValue;
+    }
+  }
+
+  arma::mat realProducts = realBasis * realVectors - imagBasis * imagVectors;
+  arma::mat imagProducts = realBasis * imagVectors + imagBasis * realVectors;
+  arma::mat realWork = realProducts * realFactors - imagProducts * imagFactors;
+  arma::mat imagWork = realProducts * imagFactors + imagProducts * realFactors;
+  realProducts = realWork * realVectors.t() + imagWork * imagVectors.t();
+  imagProducts = imagWork * realVectors.t() - realWork * imagVectors.t();
+
+  // Only the first m0 - r columns span the new complement.
+  for (unsigned int k = 0;k < newDimension;++k)
+  {
+    double *realColumn = m_RealComplement.colptr(k);
+    double *imagColumn = m_ImagComplement.colptr(k);
+    const double *realUpdate = realProducts.colptr(k);
+    const double *imagUpdate = imagProducts.colptr(k);
+
+    for (unsigned int j = 0;j < numPairs;++j)
+    {
+      realColumn[j] -= realUpdate[j];
+      imagColumn[j] -= imagUpdate[j];
+    }
+  }
+
+  m_BaseDimension = newDimension;
+  m_NumberOfReflectors = 0;
+}
+
+void ProjectionSampler::Generate(arma::mat &points, arma::uvec &labels, PhiloxGenerator &generator)
+{
+  unsigned int dimension = m_BoxLengths.n_elem;
+  unsigned int numPairs = m_EigenVectors.size() / 2;
+  points.set_size(numPairs, dimension);
+  labels.set_size(numPairs);
+
+  if (numPairs == 0)
+    return;
+
+  // Labels are proposed according to the mean squared coordinates of the
+  // eigenvectors, which bound the intensity of each type.
+  double labelProbabilities[2] = {0.0, 0.0};
+  for (unsigned int j = 0;j < numPairs;++j)
+  {
+    labelProbabilities[0] += m_EigenVectors[2 * j] * m_EigenVectors[2 * j];
+    labelProbabilities[1] += m_EigenVectors[2 * j + 1] * m_EigenVectors[2 * j + 1];
+  }
+  labelProbabilities[0] /= (double)numPairs;
+  labelProbabilities[1] /= (double)numPairs;
+
+  // The complement basis starts as the identity and loses one dimension
+  // per accepted point.
+  m_RealComplement.zeros(numPairs, numPairs);
+  m_ImagComplement.zeros(numPairs, numPairs);
+  for (unsigned int j = 0;j < numPairs;++j)
+    m_RealComplement(j, j) = 1.0;
+  m_RealReflectors.set_size(numPairs, m_MaximalNumberOfReflectors);
+  m_ImagReflectors.set_size(numPairs, m_MaximalNumberOfReflectors);
+  m_ReflectorFactors.resize(m_MaximalNumberOfReflectors);
+  m_BaseDimension = numPairs;
+  m_NumberOfReflectors = 0;
+
+  // Proposals are drawn by blocks and kept until used, since they do not
+  // depend on the previous acceptances. Pending reflections are applied to
+  // their weights on demand.
+  arma::mat realProposals(numPairs, m_MaximalBlockSize), imagProposals(numPairs, m_MaximalBlockSize);
+  arma::mat realWeights, imagWeights;
+  arma::mat proposedPoints(m_MaximalBlockSize, dimension);
+  std::vector<unsigned int> proposedLabels(m_MaximalBlockSize);
+  std::vector<unsigned int> numAppliedReflectors(m_MaximalBlockSize);
+  std::vector<double> workPoint(dimension);
+  unsigned int nextProposal = m_MaximalBlockSize;
+
+  for (unsigned int i = 0;i < numPairs;++i)
+  {
+    unsigned int currentDimension = numPairs - i;
+    unsigned int numRejections = 0;
+    int acceptedIndex = -1;
+
+    while (acceptedIndex < 0)
+    {
+      if (nextProposal == m_MaximalBlockSize)
+      {
+        for (unsigned int b = 0;b < m_MaximalBlockSize;++b)
+        {
+          proposedLabels[b] = (generator.GetUniform() < labelProbabilities[0]) ? 0 : 1;
+          for (unsigned int l = 0;l < dimension;++l)
+          {
+            workPoint[l] = m_LowerBounds[l] + m_BoxLengths[l] * generator.GetUniform();
+            proposedPoints(b, l) = workPoint[l];
+          }
+          this->EvaluateBasisFunctions(workPoint.data(), proposedLabels[b], realProposals.colptr(b), imagProposals.colptr(b));
+          numAppliedReflectors[b] = 0;
+        }
+
+        // Weights conj(Q0)^T v on the stored basis for the whole block at once
+        arma::mat realBasis(m_RealComplement.memptr(), numPairs, m_BaseDimension, false, true);
+        arma::mat imagBasis(m_ImagComplement.memptr(), numPairs, m_BaseDimension, false, true);
+        realWeights = realBasis.t() * realProposals + imagBasis.t() * imagProposals;
+        imagWeights = realBasis.t() * imagProposals - imagBasis.t() * realProposals;
+        nextProposal = 0;
+      }
+
+      unsigned int b = nextProposal;
+      ++nextProposal;
+
+      this->ApplyReflectors(realWeights.colptr(b), imagWeights.colptr(b), numAppliedReflectors[b]);
+      numAppliedReflectors[b] = m_NumberOfReflectors;
+
+      double sqNorm = 0.0;
+      for (unsigned int k = 0;k < currentDimension;++k)
+        sqNorm += realWeights(k, b) * realWeights(k, b) + imagWeights(k, b) * imagWeights(k, b);
+
+      // The basis functions at a point of label m have squared norm n p_m,
+      // which bounds the conditional intensity.
+      double acceptProbability = sqNorm / ((double)numPairs * labelProbabilities[proposedLabels[b]]);
+
+      if (generator.GetUniform() < acceptProbability)
+      {
+        acceptedIndex = b;
+        break;
+      }
+
+      ++numRejections;
+      if (numRejections > m_MaximalNumberOfRejections)
+        throw std::runtime_error("Rejection sampling failed too many times in a row.");
+    }
+
+    for (unsigned int l = 0;l < dimension;++l)
+      points(i, l) = proposedPoints(acceptedIndex, l);
+    labels[i] = proposedLabels[acceptedIndex] + 1;
+
+    if (i == numPairs - 1)
+      break;
+
+    this->AddReflector(realWeights.colptr(acceptedIndex), imagWeights.colptr(acceptedIndex));
+
+    if (m_NumberOfReflectors == m_MaximalNumberOfReflectors)
+    {
+      // Once all reflections are applied, the leading weights of the
+      // remaining proposals are their weights on the merged basis.
+      for (unsigned int b = nextProposal;b < m_MaximalBlockSize;++b)
+      {
+        this->ApplyReflectors(realWeights.colptr(b), imagWeights.colptr(b), numAppliedReflectors[b]);
+        numAppliedReflectors[b] = 0;
+      }
+
+      this->MergeReflectors();
+    }
+  }
+}
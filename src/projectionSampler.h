@@ -0,0 +1,75 @@
+#pragma once
+
+#include <RcppEnsmallen.h>
+#include "philoxGenerator.h"
+
+//! Sequential sampling of a bivariate projection DPP on a rectangular domain
+//! whose n basis functions are the Fourier modes exp(2 i pi k.x / L) times the
+//! coordinate of a 2 x 2 eigenvector at the label of the point. Points are
+//! drawn by rejection: proposals are projected by blocks onto an orthonormal
+//! basis of the complement of the accepted points, which shrinks by one
+//! Householder reflection per point, the reflections being merged into the
+//! preallocated basis storage by blocks.
+class ProjectionSampler
+{
+public:
+  ProjectionSampler()
+  {
+    m_Truncation = 0;
+    m_MaximalNumberOfRejections = 10000;
+    m_BaseDimension = 0;
+    m_NumberOfReflectors = 0;
+  }
+
+  ~ProjectionSampler() {}
+
+  void SetDomain(const arma::vec &lb, const arma::vec &boxLengths);
+  void SetTruncation(const unsigned int x) {m_Truncation = x;}
+  void SetMaximalNumberOfRejections(const unsigned int x) {m_MaximalNumberOfRejections = x;}
+
+  //! Frequencies must lie in [-N, N]^d with N the truncation
+  void AddEigenPair(const std::vector<int> &frequency, const double firstCoordinate, const double secondCoordinate);
+  unsigned int GetNumberOfEigenPairs() const {return m_EigenVectors.size() / 2;}
+
+  //! Points are returned row-wise with labels 1 or 2
+  void Generate(arma::mat &points, arma::uvec &labels, PhiloxGenerator &generator);
+
+private:
+  //! Values at the given point and label of the n basis functions, up to the
+  //! factor 1 / sqrt(V)
+  void EvaluateBasisFunctions(const double *point, const unsigned int label, double *realValues, double *imagValues) const;
+
+  //! Applies the pending reflections from the given one to the weights
+  //! c = Q0^H v of a proposal, after which its first m0 - r entries are the
+  //! weights Q^H v on the current complement basis
+  void ApplyReflectors(double *realValues, double *imagValues, const unsigned int firstReflector) const;
+
+  //! Adds the reflection I - t u u^H mapping the current weights c of an
+  //! accepted point onto a multiple of the last coordinate, which is dropped
+  void AddReflector(const double *realValues, const double *imagValues);
+
+  //! Merges the pending reflections into the stored basis with the compact WY
+  //! representation H_1 ... H_r = I - U T U^H, so that Q0 <- Q0 - (Q0 U) T U^H
+  //! is computed by matrix products
+  void MergeReflectors();
+
+  arma::vec m_LowerBounds, m_BoxLengths;
+  unsigned int m_Truncation;
+  unsigned int m_MaximalNumberOfRejections;
+
+  //! Selected eigenpairs: d integer frequencies and 2 eigenvector
+  //! coordinates per pair
+  std::vector<int> m_Frequencies;
+  std::vector<double> m_EigenVectors;
+
+  //! Orthonormal basis Q0 of size n x m0 in the first columns of
+  //! preallocated n x n storage and pending reflections u_j of length m0,
+  //! whose product spans the complement of the accepted points
+  arma::mat m_RealComplement, m_ImagComplement;
+  arma::mat m_RealReflectors, m_ImagReflectors;
+  std::vector<double> m_ReflectorFactors;
+  unsigned int m_BaseDimension, m_NumberOfReflectors;
+
+  static const unsigned int m_MaximalBlockSize = 64;
+  static const unsigned int m_MaximalNumberOfReflectors = 64;
+};
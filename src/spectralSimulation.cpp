@@ -0,0 +1,209 @@
+#include <RcppEnsmallen.h>
+#include "besselLogLikelihood.h"
+#include "gaussLogLikelihood.h"
+#include "maternLogLikelihood.h"
+#include "spectralSimulator.h"
+
+static BaseSpectralSimulator *NewSpectralSimulator(const std::string &model, const double nu)
+{
+  if (model == "bessel")
+    return new SpectralSimulator<BesselLogLikelihood>;
+
+  if (model == "gauss")
+    return new SpectralSimulator<GaussLogLikelihood>;
+
+  if (model == "matern")
+  {
+    SpectralSimulator<MaternLogLikelihood> *simulator = new SpectralSimulator<MaternLogLikelihood>;
+    simulator->GetModel().SetSmoothness(nu);
+    return simulator;
+  }
+
+  Rcpp::stop("The model should be either bessel, gauss or matern.");
+}
+
+//' Spectral Plans for the Simulation of Stationary Bivariate DPPs
+//'
+//' `CreateSpectralPlan()` computes once the truncation and the spectral
+//' decomposition of a stationary bivariate Bessel, Gaussian or Matern DPP on
+//' a rectangular domain. `SampleSpectralPlan()` then draws point patterns
+//' from it without recomputing them. Since the spectral matrices are radial,
+//' they are only computed for frequencies with non-negative coordinates,
+//' sorted when the domain is a cube.
+//'
+//' @param model Either `"bessel"`, `"gauss"` or `"matern"`.
+//' @param rho1 Intensity of the first type of points.
+//' @param rho2 Intensity of the second type of points.
+//' @param alpha1 Alpha parameter of the first marginal kernel.
+//' @param alpha2 Alpha parameter of the second marginal kernel.
+//' @param alpha12 Alpha parameter of the cross kernel.
+//' @param tau Correlation between both types of points.
+//' @param lb A d-dimensional vector storing the lower bounds of the domain.
+//' @param ub A d-dimensional vector storing the upper bounds of the domain.
+//' @param nu Smoothness parameter of the Matern kernels (default: 10).
+//' @param precision Fraction of the expected number of points that the
+//'   truncated spectral decomposition should capture. If `NA` (default), it
+//'   is 0.95 for the Bessel model and 0.99 otherwise.
+//' @param reject_max Maximal number of consecutive rejections when sampling
+//'   one point (default: 10000).
+//'
+//' @return `CreateSpectralPlan()` returns an external pointer to the plan.
+//'   `SampleSpectralPlan()` returns a list of `n` simulations, each of which
+//'   is a list with the n x d matrix `x` of the point coordinates and the
+//'   vector `marks` of their labels (1 or 2).
+//'
+//' @export
+// [[Rcpp::export]]
+SEXP CreateSpectralPlan(
+    const std::string model,
+    const double rho1,
+    const double rho2,
+    const double alpha1,
+    const double alpha2,
+    const double alpha12,
+    const double tau,
+    const arma::vec &lb,
+    const arma::vec &ub,
+    const double nu = 10.0,
+    const double precision = NA_REAL,
+    const unsigned int reject_max = 10000)
+{
+  if (lb.n_elem != ub.n_elem)
+    Rcpp::stop("The lower and upper bounds should have the same length.");
+
+  double workPrecision = precision;
+  if (!arma::is_finite(workPrecision))
+    workPrecision = (model == "bessel") ? 0.95 : 0.99;
+
+  BaseSpectralSimulator *simulator = NewSpectralSimulator(model, nu);
+  Rcpp::XPtr<BaseSpectralSimulator> simulatorPtr(simulator, true);
+  simulator->SetDomain(lb, ub);
+  simulator->SetParameters(rho1, rho2, alpha1, alpha2, alpha12, tau);
+  simulator->SetPrecision(workPrecision);
+  simulator->SetMaximalNumberOfRejections(reject_max);
+
+  try
+  {
+    simulator->ComputeSpectralDecomposition();
+  }
+  catch (std::exception &e)
+  {
+    Rcpp::stop(e.what());
+  }
+
+  return simulatorPtr;
+}
+
+//' @rdname CreateSpectralPlan
+//'
+//' @param plan A spectral plan created by `CreateSpectralPlan()`.
+//' @param n Number of point patterns to draw (default: 1).
+//' @param seed Seed of the counter-based random number generator. The i-th
+//'   pattern only depends on the seed and on i, whatever the number of
+//'   threads. If `NA` (default), it is drawn from the R generator.
+//' @param num_threads Number of patterns drawn concurrently (default: 1).
+//'
+//' @export
+// [[Rcpp::export]]
+Rcpp::List SampleSpectralPlan(
+    SEXP plan,
+    const unsigned int n = 1,
+    const double seed = NA_REAL,
+    const unsigned int num_threads = 1)
+{
+  Rcpp::XPtr<BaseSpectralSimulator> simulator(plan);
+
+  if (seed < 0.0)
+    Rcpp::stop("The seed should be non-negative.");
+
+  uint64_t workSeed = 0;
+  if (arma::is_finite(seed))
+    workSeed = (uint64_t)seed;
+  else
+  {
+    workSeed = (uint64_t)(R::unif_rand() * 4294967296.0);
+    workSeed = (workSeed << 32) | (uint64_t)(R::unif_rand() * 4294967296.0);
+  }
+
+  // R objects cannot be accessed from the worker threads.
+  std::vector<arma::mat> pointsVector(n);
+  std::vector<arma::uvec> labelsVector(n);
+  std::vector<std::string> sampleErrors(n);
+  const BaseSpectralSimulator *workSimulator = simulator.get();
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+#endif
+  for (unsigned int i = 0;i < n;++i)
+  {
+    try
+    {
+      PhiloxGenerator generator(workSeed, i);
+      workSimulator->Generate(pointsVector[i], labelsVector[i], generator);
+    }
+    catch (std::exception &e)
+    {
+      sampleErrors[i] = e.what();
+    }
+  }
+
+  for (unsigned int i = 0;i < n;++i)
+  {
+    if (!sampleErrors[i].empty())
+      Rcpp::stop("Simulation %d failed: %s", i + 1, sampleErrors[i]);
+  }
+
+  Rcpp::List resList(n);
+  for (unsigned int i = 0;i < n;++i)
+  {
+    resList[i] = Rcpp::List::create(
+      Rcpp::Named("x") = pointsVector[i],
+      Rcpp::Named("marks") = labelsVector[i]
+    );
+  }
+
+  return resList;
+}
+
+//' Spectral Simulation of Stationary Bivariate DPPs
+//'
+//' This function draws a point pattern from a stationary bivariate Bessel,
+//' Gaussian or Matern DPP on a rectangular domain by the spectral method.
+//' Use [CreateSpectralPlan()] to draw several patterns with the same
+//' parameters.
+//'
+//' @inheritParams CreateSpectralPlan
+//' @param seed Seed of the counter-based random number generator. If `NA`
+//'   (default), it is drawn from the R generator.
+//'
+//' @return A list with the n x d matrix `x` of the point coordinates, the
+//'   vector `marks` of their labels (1 or 2) and the `truncation` N of the
+//'   frequencies in [-N, N]^d.
+//'
+//' @export
+// [[Rcpp::export]]
+Rcpp::List SimulateBivariateDPP(
+    const std::string model,
+    const double rho1,
+    const double rho2,
+    const double alpha1,
+    const double alpha2,
+    const double alpha12,
+    const double tau,
+    const arma::vec &lb,
+    const arma::vec &ub,
+    const double nu = 10.0,
+    const double precision = NA_REAL,
+    const unsigned int reject_max = 10000,
+    const double seed = NA_REAL)
+{
+  Rcpp::XPtr<BaseSpectralSimulator> simulator(CreateSpectralPlan(model, rho1, rho2, alpha1, alpha2, alpha12, tau, lb, ub, nu, precision, reject_max));
+  Rcpp::List sampleList = SampleSpectralPlan(simulator, 1, seed);
+  Rcpp::List workList = sampleList[0];
+
+  return Rcpp::List::create(
+    Rcpp::Named("x") = workList["x"],
+    Rcpp::Named("marks") = workList["marks"],
+    Rcpp::Named("truncation") = simulator->GetTruncation()
+  );
+}
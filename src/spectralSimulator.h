@@ -0,0 +1,32 @@
+#pragma once
+
+#include "baseSpectralSimulator.h"
+
+//! Spectral simulator using the Fourier kernels and amplitudes of the
+//! log-likelihood class TModel, of which it holds its own instance
+template <class TModel>
+class SpectralSimulator : public BaseSpectralSimulator
+{
+public:
+  SpectralSimulator() {}
+  ~SpectralSimulator() {}
+
+  //! Model-specific settings, such as the Matern smoothness, must be set
+  //! before computing the spectral decomposition.
+  TModel &GetModel() {return m_Model;}
+
+protected:
+  double GetFourierKernel(const double radius, const double alpha, const bool cross) const
+  {
+    double derivative = 0.0;
+    return m_Model.GetFourierKernel(radius, alpha, this->GetDomainDimension(), cross, derivative);
+  }
+
+  double GetAmplitude(const double intensity, const double alpha)
+  {
+    return m_Model.RetrieveAmplitudeFromParameters(intensity, alpha, this->GetDomainDimension());
+  }
+
+private:
+  TModel m_Model;
+};
@@ -0,0 +1,68 @@
+#include "stochasticLogDeterminant.h"
+#include "philoxGenerator.h"
+
+void StochasticLogDeterminant::GenerateProbes(const unsigned int n)
+{
+  // One stream per probe, so that a probe does not depend on the others
+  m_Probes.set_size(n, m_NumberOfProbes);
+
+  for (unsigned int p = 0;p < m_NumberOfProbes;++p)
+  {
+    PhiloxGenerator generator(m_Seed, p);
+    for (unsigned int i = 0;i < n;++i)
+      m_Probes(i, p) = (generator.GetUniform() < 0.5) ? -1.0 : 1.0;
+  }
+}
+
+double StochasticLogDeterminant::GetQuadrature(const std::vector<double> &alphaValues, const std::vector<double> &betaValues) const
+{
+  // Lanczos tridiagonal matrix of conjugate gradients (Saad, 2003, Section
+  // 6.7.3):
+  //   T_kk = 1 / alpha_k + beta_(k-1) / alpha_(k-1)
+  //   T_k(k+1) = sqrt(beta_k) / alpha_k
+  unsigned int numSteps = alphaValues.size();
+  arma::mat tridiagonalMatrix(numSteps, numSteps);
+  tridiagonalMatrix.fill(0.0);
+
+  for (unsigned int k = 0;k < numSteps;++k)
+  {
+    tridiagonalMatrix(k, k) = 1.0 / alphaValues[k];
+    if (k > 0)
+      tridiagonalMatrix(k, k) += betaValues[k - 1] / alphaValues[k - 1];
+
+    if (k + 1 < numSteps)
+    {
+      double offDiagonalValue = std::sqrt(betaValues[k]) / alphaValues[k];
+      tridiagonalMatrix(k, k + 1) = offDiagonalValue;
+      tridiagonalMatrix(k + 1, k) = offDiagonalValue;
+    }
+  }
+
+  arma::vec eigenValues;
+  arma::mat eigenVectors;
+  if (!arma::eig_sym(eigenValues, eigenVectors, tridiagonalMatrix))
+    return NA_REAL;
+
+  // Nodes are the eigenvalues of T and weights the squared first components
+  // of its eigenvectors.
+  double resVal = 0.0;
+  for (unsigned int k = 0;k < numSteps;++k)
+  {
+    if (!(eigenValues[k] > 0.0))
+      return NA_REAL;
+
+    resVal += eigenVectors(0, k) * eigenVectors(0, k) * std::log(eigenValues[k]);
+  }
+
+  return resVal;
+}
+
+void StochasticLogDeterminant::SetEstimates(const arma::vec &probeEstimates)
+{
+  unsigned int numProbes = probeEstimates.n_elem;
+  m_LogDeterminant = arma::mean(probeEstimates);
+  m_StandardError = NA_REAL;
+
+  if (numProbes > 1)
+    m_StandardError = arma::stddev(probeEstimates) / std::sqrt((double)numProbes);
+}
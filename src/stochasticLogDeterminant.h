@@ -0,0 +1,150 @@
+#pragma once
+
+#include <RcppEnsmallen.h>
+#include <stdint.h>
+#include <limits>
+
+//! Stochastic Lanczos quadrature of the log-determinant of a symmetric
+//! positive definite matrix L that is only known through products L X with
+//! blocks of vectors. Conjugate gradients are run on Rademacher probes z,
+//! which gives both the solutions of L u = z and, from the step lengths of
+//! the iterations, the Lanczos tridiagonal matrices T used in the Gauss
+//! quadrature z^T log(L) z ~ |z|^2 e_1^T log(T) e_1. The log-determinant is
+//! the mean over probes of this quadrature (Hutchinson estimator of
+//! trace(log(L))) and its standard error is reported. Probes are drawn from
+//! counter-based streams so that they only depend on the seed: repeated
+//! evaluations share them. Each probe runs the same fixed number of steps,
+//! rather than stopping at a residual tolerance, so that the estimate is a
+//! smooth function of L: a tolerance would change the number of steps, and
+//! thus make the estimate jump, from one L to the next.
+class StochasticLogDeterminant
+{
+public:
+  StochasticLogDeterminant()
+  {
+    m_NumberOfProbes = 30;
+    m_NumberOfSteps = 50;
+    m_Seed = 0;
+    m_LogDeterminant = 0.0;
+    m_StandardError = 0.0;
+  }
+
+  ~StochasticLogDeterminant() {}
+
+  void SetNumberOfProbes(const unsigned int n) {m_NumberOfProbes = (n > 0) ? n : 1;}
+  void SetSeed(const uint64_t x) {m_Seed = x;}
+
+  //! Number of steps run for each probe (50 by default). A probe only stops
+  //! earlier if its residual vanishes to round-off, in which case its Krylov
+  //! space is invariant and further steps would not change its quadrature.
+  void SetNumberOfSteps(const unsigned int n) {m_NumberOfSteps = (n > 0) ? n : 1;}
+
+  //! Runs the iterations for an n x n matrix given by multiply(x, y), which
+  //! must set y = L x for an n x p block x. Returns false if L is found not
+  //! to be positive definite.
+  template <class TOperator>
+  bool Compute(const unsigned int n, TOperator &multiply);
+
+  double GetLogDeterminant() const {return m_LogDeterminant;}
+  double GetStandardError() const {return m_StandardError;}
+
+  //! Probes z and approximate solutions u = inv(L) z stored column-wise,
+  //! after the fixed number of steps
+  const arma::mat &GetProbes() const {return m_Probes;}
+  const arma::mat &GetSolutions() const {return m_Solutions;}
+
+private:
+  void GenerateProbes(const unsigned int n);
+
+  //! Quadrature e_1^T log(T) e_1 from the conjugate gradient step lengths
+  //! alpha_k and beta_k of a probe, or NaN if T is not positive definite
+  double GetQuadrature(const std::vector<double> &alphaValues, const std::vector<double> &betaValues) const;
+
+  //! Mean and standard error of the quadratures of all probes
+  void SetEstimates(const arma::vec &probeEstimates);
+
+  unsigned int m_NumberOfProbes, m_NumberOfSteps;
+  uint64_t m_Seed;
+  double m_LogDeterminant, m_StandardError;
+  arma::mat m_Probes, m_Solutions;
+};
+
+template <class TOperator>
+bool StochasticLogDeterminant::Compute(const unsigned int n, TOperator &multiply)
+{
+  this->GenerateProbes(n);
+  unsigned int numProbes = m_NumberOfProbes;
+
+  m_Solutions.zeros(n, numProbes);
+  arma::mat residuals = m_Probes;
+  arma::mat directions = m_Probes;
+  arma::mat products;
+
+  // All probes have |z|^2 = n.
+  double sqThreshold = std::numeric_limits<double>::epsilon() * std::numeric_limits<double>::epsilon() * (double)n;
+  std::vector<double> sqResidualNorms(numProbes, (double)n);
+  std::vector<std::vector<double> > alphaValues(numProbes), betaValues(numProbes);
+  std::vector<bool> activeProbes(numProbes, true);
+  unsigned int numActiveProbes = numProbes;
+
+  for (unsigned int k = 0;k < m_NumberOfSteps && numActiveProbes > 0;++k)
+  {
+    multiply(directions, products);
+
+    for (unsigned int p = 0;p < numProbes;++p)
+    {
+      if (!activeProbes[p])
+        continue;
+
+      double *directionValues = directions.colptr(p);
+      double *residualValues = residuals.colptr(p);
+      double *solutionValues = m_Solutions.colptr(p);
+      const double *productValues = products.colptr(p);
+
+      double curvatureValue = 0.0;
+      for (unsigned int i = 0;i < n;++i)
+        curvatureValue += directionValues[i] * productValues[i];
+
+      if (!(curvatureValue > 0.0))
+        return false;
+
+      double alphaValue = sqResidualNorms[p] / curvatureValue;
+      double sqResidualNorm = 0.0;
+      for (unsigned int i = 0;i < n;++i)
+      {
+        solutionValues[i] += alphaValue * directionValues[i];
+        residualValues[i] -= alphaValue * productValues[i];
+        sqResidualNorm += residualValues[i] * residualValues[i];
+      }
+
+      double betaValue = sqResidualNorm / sqResidualNorms[p];
+      sqResidualNorms[p] = sqResidualNorm;
+      alphaValues[p].push_back(alphaValue);
+      betaValues[p].push_back(betaValue);
+
+      // Probes whose residual vanished no longer contribute to the products.
+      if (sqResidualNorm < sqThreshold)
+      {
+        activeProbes[p] = false;
+        --numActiveProbes;
+      }
+
+      for (unsigned int i = 0;i < n;++i)
+        directionValues[i] = (activeProbes[p]) ? residualValues[i] + betaValue * directionValues[i] : 0.0;
+    }
+  }
+
+  arma::vec probeEstimates(numProbes);
+  for (unsigned int p = 0;p < numProbes;++p)
+  {
+    double quadratureValue = this->GetQuadrature(alphaValues[p], betaValues[p]);
+    if (!std::isfinite(quadratureValue))
+      return false;
+
+    probeEstimates[p] = (double)n * quadratureValue;
+  }
+
+  this->SetEstimates(probeEstimates);
+
+  return true;
+}
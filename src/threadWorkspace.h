@@ -0,0 +1,34 @@
+#pragma once
+
+#include <RcppEnsmallen.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//! Work array of the iterations of an OpenMP loop, allocated once per thread
+//! before the parallel region instead of once per iteration, which also keeps
+//! allocation failures out of the region. The region must not run more
+//! threads than the workspace was created for. GetValues() returns the array
+//! of the calling thread.
+class ThreadWorkspace
+{
+public:
+  ThreadWorkspace(const unsigned int numThreads, const arma::uword size)
+  {
+    m_Values.set_size(std::max(size, (arma::uword)1), std::max(numThreads, 1u));
+  }
+
+  ~ThreadWorkspace() {}
+
+  double *GetValues()
+  {
+#ifdef _OPENMP
+    return m_Values.colptr(omp_get_thread_num());
+#else
+    return m_Values.memptr();
+#endif
+  }
+
+private:
+  arma::mat m_Values;
+};